@@ -0,0 +1,112 @@
+/*
+ * File:   circle_benchmark.c
+ * Author: jeffglaum
+ *
+ * Created on February 11, 2024, 9:30 AM
+ */
+
+// Instruction cycles taken by SH1106_DrawCircle() and by the floating point
+// version it replaced, for a few radii filled and as outlines, printed over
+// UART1.  Build with CIRCLE_BENCHMARK=1 and call CircleBenchmark_Run() once
+// UART1 is up; Timer4/5 are used as a 32-bit cycle counter while it runs and the
+// circles are drawn into a scratch buffer rather than the frame buffer.
+
+#include "xc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "uart.h"
+#include "sh1106_panel.h"
+#include "circle_benchmark.h"
+
+#if CIRCLE_BENCHMARK && SH1106_USE_FRAMEBUFFER
+
+// SH1106_DrawCircle() as it was: sqrt() per column when filled, sin() and cos()
+// every 4 degrees for an outline.
+static void FloatDrawCircle(uint8_t x, uint8_t y, uint8_t r, uint16_t color, bool fill)
+{
+    int8_t mx = 0;
+    int8_t my;
+
+    if (fill)
+    {
+        for (mx=r ; mx>=-r ; mx--)
+        {
+            my = sqrt(r*r - mx*mx);
+            SH1106_DrawFastVLine((x+mx), (y-my), (my*2), color);
+        }
+    }
+    else
+    {
+        float radians = 0;
+        for (radians=0 ; radians < TWO_PI ; radians += (4.0 * ONE_RADIAN))
+        {
+            uint8_t mx =   (x + (r * cos(radians)));
+            uint8_t my =   (y + (r * sin(radians)));
+            SH1106_DrawPixel(mx, my, color);
+        }
+    }
+}
+
+// Timer4/5 as one 32-bit counter running at FCY counts instruction cycles.
+static uint32_t CircleBenchmark_Cycles(void)
+{
+    uint16_t lsw = TMR4;
+
+    return (((uint32_t)TMR5HLD << 16) | lsw);
+}
+
+// Time each version at each radius and print the results.  Draws into a scratch
+// buffer, so whatever is already in the frame buffer is left alone.
+void CircleBenchmark_Run(void)
+{
+    static const uint8_t radii[] = { 4, 8, 16, 31 };
+    static uint8_t scratch[SH1106_BUFFER_SIZE_BYTES];
+    uint32_t start, floatCycles, midpointCycles;
+    uint8_t i, fill;
+
+    SH1106_SetDrawTarget(scratch);
+
+    T4CON = 0;
+    T5CON = 0;
+    T4CONbits.T32 = 1;
+    TMR5 = 0;
+    TMR4 = 0;
+    PR5  = 0xFFFF;
+    PR4  = 0xFFFF;
+    T4CONbits.TON = 1;
+
+    for (i = 0; i < sizeof(radii); i++)
+    {
+        for (fill = 0; fill < 2; fill++)
+        {
+            start = CircleBenchmark_Cycles();
+            FloatDrawCircle(64, 32, radii[i], WHITE, fill);
+            floatCycles = CircleBenchmark_Cycles() - start;
+
+            start = CircleBenchmark_Cycles();
+            SH1106_DrawCircle(64, 32, radii[i], WHITE, fill);
+            midpointCycles = CircleBenchmark_Cycles() - start;
+
+            while (UART1_TxFree() < 80)
+            {
+            }
+            UART1_printf("circle r=%u %s: float %lu cycles, midpoint %lu cycles\r\n",
+                         radii[i], (fill ? "fill" : "outline"), floatCycles, midpointCycles);
+        }
+    }
+
+    T4CONbits.TON = 0;
+    SH1106_SetDrawTarget(NULL);
+}
+
+#else
+
+void CircleBenchmark_Run(void)
+{
+}
+
+#endif
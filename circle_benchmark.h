@@ -0,0 +1,13 @@
+#pragma once
+
+// Times SH1106_DrawCircle() against the floating point version it replaced.
+// Built with CIRCLE_BENCHMARK=1 (and a frame buffer); see circle_benchmark.c.
+// 2024-02-11 Jeff Glaum
+
+#include <xc.h> // include processor files - each processor file is guarded.
+
+#ifndef CIRCLE_BENCHMARK
+#define CIRCLE_BENCHMARK    0
+#endif
+
+void CircleBenchmark_Run(void);
@@ -13,6 +13,7 @@
 
 #include "gfxfont.h"
 #include "sh1106_panel.h"
+#include "sh1106_displaylist.h"
 
 #ifndef pgm_read_byte
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
@@ -63,6 +64,15 @@ void SetFont(const GFXfont *f) {
   gfxFont = (GFXfont *)f;
 }
 
+const GFXfont *GetFont(void) {
+  return gfxFont;
+}
+
+void SetCursor(int16_t x, int16_t y) {
+  cursor_x = x;
+  cursor_y = y;
+}
+
 void SetTextSize(uint8_t s_x, uint8_t s_y) {
   textsize_x = (s_x > 0) ? s_x : 1;
   textsize_y = (s_y > 0) ? s_y : 1;
@@ -92,6 +102,11 @@ void DrawChar(int16_t x, int16_t y, unsigned char c,
                             uint16_t color, uint16_t bg, uint8_t size_x,
                             uint8_t size_y) {
 
+    if (SH1106_DL_IsRecording()) {
+      SH1106_DL_AddChar(gfxFont, x, y, c, color, size_x, size_y);
+      return;
+    }
+
    // Custom font
 
     // Character is assumed previously filtered by write() to eliminate
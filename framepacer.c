@@ -0,0 +1,153 @@
+/*
+ * File:   framepacer.c
+ * Author: jeffglaum
+ *
+ * Created on January 27, 2024, 2:40 PM
+ */
+
+// Paces the display loop to a target frame rate using Timer2 as a free running
+// time base.  Frames start on a fixed grid of slots.  A frame runs from the start
+// of its rendering until the flush it started has finished on the bus, so the bus
+// time counts towards the frame time and overruns.  A frame that overruns its
+// slot gives up the slots it ran into rather than trying to catch up, and a
+// present made while the previous flush is still on the bus is left dirty so it
+// goes out with the next one.
+
+#include "xc.h"
+
+#include <stdbool.h>
+
+#include "system.h"
+#include "sh1106_panel.h"
+#include "framepacer.h"
+
+// Timer2 runs from FCY / 64, wrapping every 65536 ticks (about 1 s at 4 MIPS), so
+// frames must be shorter than that to be measured correctly.
+#define FRAMEPACER_PRESCALE         64
+#define FRAMEPACER_TICKS_PER_SEC    ((FCY) / FRAMEPACER_PRESCALE)
+#define FRAMEPACER_TICKS_TO_US(t)   ((((uint32_t)(t)) * FRAMEPACER_PRESCALE * 1000UL) / ((FCY) / 1000))
+
+// Longest a frame waits for its flush (a whole frame at 100 kHz takes about 95 ms).
+// A flush that stalls is timed out by the next one.
+#define FRAMEPACER_FLUSH_WAIT       (FRAMEPACER_TICKS_PER_SEC / 4)
+
+static uint16_t frame_period;       // Ticks per frame slot.
+static uint16_t slot_start;         // Start of the current frame slot.
+static uint16_t frame_start;        // When the current frame actually started.
+static bool frame_flushing;         // The current frame started a flush.
+
+static uint16_t min_ticks;
+static uint16_t max_ticks;
+static uint32_t sum_ticks;
+static uint16_t frame_count;
+static uint16_t dropped_count;
+static uint16_t coalesced_count;
+
+
+// Start Timer2 and pace frames at fps frames per second (at least 1).
+void FramePacer_Init(uint8_t fps)
+{
+    if (fps == 0)
+    {
+        fps = 1;
+    }
+
+    T2CON = 0;
+    T2CONbits.TCKPS = 0b10;         // 1:64 prescale.
+    TMR2 = 0;
+    PR2  = 0xFFFF;                  // Free running.
+    IEC0bits.T2IE = 0;
+    T2CONbits.TON = 1;
+
+    frame_period   = FRAMEPACER_TICKS_PER_SEC / fps;
+    slot_start     = TMR2;
+    frame_start    = slot_start;
+    frame_flushing = false;
+
+    FramePacer_ResetStats();
+}
+
+// Mark the start of a frame's rendering.
+void FramePacer_BeginFrame(void)
+{
+    frame_start = TMR2;
+}
+
+// Start sending the frame unless the previous one is still on the bus, in which
+// case this frame's changes are left to go out with the next flush.  Returns true
+// if a flush was started.
+bool FramePacer_Present(void)
+{
+    if (!SH1106_DisplayAsync())
+    {
+        coalesced_count++;
+        return false;
+    }
+
+    frame_flushing = true;
+    return true;
+}
+
+// Finish the frame: wait for the flush it started to finish, record how long the
+// frame took, then wait for the start of the next frame slot.  A frame that ran
+// past the end of its slot (usually because of the bus) drops the slots it
+// overran and the next frame starts on the following slot boundary.
+void FramePacer_EndFrame(void)
+{
+    uint16_t now = TMR2;
+    uint16_t ticks, elapsed;
+
+    if (frame_flushing)
+    {
+        uint16_t wait_start = now;
+
+        while (SH1106_IsFlushBusy() && ((uint16_t)(TMR2 - wait_start) < FRAMEPACER_FLUSH_WAIT))
+        {
+        }
+
+        now            = TMR2;
+        frame_flushing = false;
+    }
+
+    ticks   = now - frame_start;
+    elapsed = now - slot_start;
+
+    if (ticks < min_ticks) { min_ticks = ticks; }
+    if (ticks > max_ticks) { max_ticks = ticks; }
+    sum_ticks += ticks;
+    frame_count++;
+
+    if (elapsed >= frame_period)
+    {
+        uint16_t missed = elapsed / frame_period;
+
+        dropped_count += missed;
+        slot_start    += (missed * frame_period);
+    }
+
+    while ((uint16_t)(TMR2 - slot_start) < frame_period)
+    {
+    }
+
+    slot_start += frame_period;
+}
+
+void FramePacer_GetStats(FramePacer_Stats *stats)
+{
+    stats->minFrameUs = (frame_count > 0) ? FRAMEPACER_TICKS_TO_US(min_ticks) : 0;
+    stats->avgFrameUs = (frame_count > 0) ? FRAMEPACER_TICKS_TO_US(sum_ticks / frame_count) : 0;
+    stats->maxFrameUs = FRAMEPACER_TICKS_TO_US(max_ticks);
+    stats->frames     = frame_count;
+    stats->dropped    = dropped_count;
+    stats->coalesced  = coalesced_count;
+}
+
+void FramePacer_ResetStats(void)
+{
+    min_ticks       = 0xFFFF;
+    max_ticks       = 0;
+    sum_ticks       = 0;
+    frame_count     = 0;
+    dropped_count   = 0;
+    coalesced_count = 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Fixed rate frame scheduling for the display loop.
+// 2024-01-27 Jeff Glaum
+
+#include <xc.h> // include processor files - each processor file is guarded.
+
+#include <stdbool.h>
+
+// Frame timing accumulated since FramePacer_Init() or FramePacer_ResetStats().
+typedef struct {
+  uint32_t minFrameUs;      ///< Shortest frame (render + flush), microseconds
+  uint32_t avgFrameUs;      ///< Average frame, microseconds
+  uint32_t maxFrameUs;      ///< Longest frame, microseconds
+  uint16_t frames;          ///< Frames completed
+  uint16_t dropped;         ///< Frame slots missed because a frame overran
+  uint16_t coalesced;       ///< Presents folded into the next flush (bus busy)
+} FramePacer_Stats;
+
+void FramePacer_Init(uint8_t fps);
+void FramePacer_BeginFrame(void);
+bool FramePacer_Present(void);
+void FramePacer_EndFrame(void);
+void FramePacer_GetStats(FramePacer_Stats *stats);
+void FramePacer_ResetStats(void);
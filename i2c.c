@@ -1,7 +1,9 @@
 #include <xc.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "delay.h"
 #include "i2c.h"
-#//include <serial.h>
+#include "uart.h"
 
 
 #if _ENABLE_DEBUG
@@ -13,6 +15,22 @@
 //-------------------Variables-------------------
 uint16_t I2Cflags;
 
+// Interrupt-driven write state.
+#define I2C_ASYNC_IDLE		0		// No transfer in progress
+#define I2C_ASYNC_START		1		// Waiting for START to complete
+#define I2C_ASYNC_WRITE		2		// Waiting for a byte to be transmitted and acknowledged
+#define I2C_ASYNC_STOP		3		// Waiting for STOP to complete
+
+static volatile uint8_t AsyncState = I2C_ASYNC_IDLE;
+static uint8_t AsyncSlaveAddr;
+static uint8_t *AsyncHeader;
+static uint16_t AsyncHdrCnt;
+static uint8_t *AsyncBuffer;
+static uint16_t AsyncByteCnt;
+static uint16_t AsyncIndex;
+static int AsyncResult;
+static I2C_AsyncCallback AsyncCallback;
+
 
 //-------------------Functions-------------------
 
@@ -52,8 +70,9 @@ void I2C_ModuleStart()
 	IFS1bits.MI2C1IF = 0;			// Clear the I2C master interrupt flag.
 	I2C1CONbits.I2CEN = 1;			// Enable I2C controller.
 
-	// NOTE: used for interrupt-driven code.
-	//IEC1bits.MI2C1IE = 1;			// Enable the I2C master interrupt.
+	// NOTE: the I2C master interrupt is only enabled by I2C1_M_WriteAsync() for
+	// the duration of an interrupt-driven transfer.
+	IEC1bits.MI2C1IE = 0;
 }
 
 
@@ -341,21 +360,21 @@ static int I2C1_M_Stop()
 }
 
 
-// Poll an I2C device to see if it is alive.
-//
-// This should be done periodically (say every 1 second).  Also handle
-// error recovery of the I2C bus if needed.
+// Return the I2C bus to a known state if an error left it dirty, so transfers
+// can carry on without waiting for the next poll.
 //
 // Return Values:
-//	I2C_OK
-//	I2C_Err_BadAddr
-//	I2C_Err_CommFail
+//	I2C_OK			(bus was clean or has been recovered)
+//	I2C_Err_Busy
 //	I2C_Err_Hardware
 //*******************************************************************************
-int  I2C1_M_Poll(uint8_t DevAddr)
+int  I2C1_M_Recover(void)
 {
-	uint8_t SlaveAddr = (DevAddr << 1) | 0;
-
+	// Leave the bus alone while an interrupt-driven transfer owns it.
+	if (AsyncState != I2C_ASYNC_IDLE)
+	{
+		return I2C_Err_Busy;
+	}
 
 	// Handle cleaning the I2C bus if needed.
 	if (IsI2C1BusDirty)
@@ -375,6 +394,34 @@ int  I2C1_M_Poll(uint8_t DevAddr)
 		ClrI2C1BusDirty;
 	}
 
+	return I2C_OK;
+}
+
+
+// Poll an I2C device to see if it is alive.
+//
+// This should be done periodically (say every 1 second).  Also handle
+// error recovery of the I2C bus if needed.
+//
+// Return Values:
+//	I2C_OK
+//	I2C_Err_BadAddr
+//	I2C_Err_Busy
+//	I2C_Err_CommFail
+//	I2C_Err_Hardware
+//*******************************************************************************
+int  I2C1_M_Poll(uint8_t DevAddr)
+{
+	uint8_t SlaveAddr = (DevAddr << 1) | 0;
+	int retval;
+
+
+	retval = I2C1_M_Recover();
+	if (retval != I2C_OK)
+	{
+		return retval;
+	}
+
 	// Cycle through a START -> write -> STOP cycle to the target.
 	if (I2C1_M_Start() != I2C_OK)
 	{
@@ -382,7 +429,7 @@ int  I2C1_M_Poll(uint8_t DevAddr)
 		goto FailureExit;
 	}
 
-	int retval = I2C1_M_WriteByte(SlaveAddr);
+	retval = I2C1_M_WriteByte(SlaveAddr);
 
 	// Even if we have an error sending, try to close the I2C transaction.
 	if (I2C1_M_Stop() != I2C_OK)
@@ -423,11 +470,33 @@ FailureExit:
 //	I2C_Err_CommFail
 //*******************************************************************************
 int  I2C1_M_Read(uint8_t DevAddr, uint8_t SubAddr, uint16_t ByteCnt, uint8_t *buffer)
+{
+	return I2C1_M_ReadEx(DevAddr, 1, &SubAddr, ByteCnt, buffer);
+}
+
+
+// Writes a header (ex: register address or control/command bytes) to target
+// address, then reads data from target into buffer provided after a repeated
+// START, all within a single transaction.
+// 
+// Return Values:
+//	I2C_Ok
+//	I2C_Err_BadAddr
+//	I2C_Err_BusDirty
+//	I2C_Err_CommFail
+//*******************************************************************************
+int  I2C1_M_ReadEx(uint8_t DevAddr, uint16_t HdrCnt, uint8_t *header, uint16_t ByteCnt, uint8_t *buffer)
 {
 	int errorValue = I2C_Err_CommFail;
 	uint8_t SlaveAddr = (DevAddr << 1) | 0;		// Write bit.
 
 	
+	// Leave the bus alone while an interrupt-driven transfer owns it.
+	if (AsyncState != I2C_ASYNC_IDLE)
+	{
+		return I2C_Err_Busy;
+	}
+
 	// Skip any reads until the I2C bus is in a known state.
 	if (IsI2C1BusDirty)
 	{
@@ -461,12 +530,16 @@ int  I2C1_M_Read(uint8_t DevAddr, uint8_t SubAddr, uint16_t ByteCnt, uint8_t *bu
 		goto FailureExit;
 	}
 
-	// Send the I2C target device register address.
-	if (I2C1_M_WriteByte(SubAddr) != I2C_OK)
+	// Send the header bytes (ex: the I2C target device register address).
+	unsigned int i=0;
+	for (i=0; i < HdrCnt; i++)
 	{
-		DEBUG_printf("ERROR: Failed to address target I2C device register on read.\r\n");
-		I2C1_M_Stop();
-		goto FailureExit;
+		if (I2C1_M_WriteByte(header[i]) != I2C_OK)
+		{
+			DEBUG_printf("ERROR: Failed to address target I2C device register on read.\r\n");
+			I2C1_M_Stop();
+			goto FailureExit;
+		}
 	}
 
 	// Send repeated START message to switch to read mode.
@@ -488,7 +561,6 @@ int  I2C1_M_Read(uint8_t DevAddr, uint8_t SubAddr, uint16_t ByteCnt, uint8_t *bu
 	}
 	
 	// Fetch each of the response bytes from the target.
-	unsigned int i=0;
 	for (i=0; i < ByteCnt; i++)
 	{
 		// Send a NACK on the last byte so the target knows this is the end.
@@ -617,11 +689,33 @@ int I2C1_M_ReadByte(uint8_t ACKflag)
 //	I2C_Err_CommFail
 //*******************************************************************************
 int I2C1_M_Write(uint8_t DevAddr, uint8_t SubAddr, uint16_t ByteCnt, uint8_t *buffer)
+{
+	return I2C1_M_WriteEx(DevAddr, 1, &SubAddr, ByteCnt, buffer);
+}
+
+
+// Writes a header (ex: register address or control/command bytes) followed by
+// the data provided in buffer to target address, all within a single
+// START -> write -> STOP cycle.
+//
+// Return Values:
+//	I2C_OK
+//	I2C_Err_BadAddr
+//	I2C_Err_BusDirty
+//	I2C_Err_CommFail
+//*******************************************************************************
+int I2C1_M_WriteEx(uint8_t DevAddr, uint16_t HdrCnt, uint8_t *header, uint16_t ByteCnt, uint8_t *buffer)
 {
 	int errorValue = I2C_Err_CommFail;
 	uint8_t SlaveAddr = (DevAddr << 1) | 0;		// Write bit.
 
 	
+	// Leave the bus alone while an interrupt-driven transfer owns it.
+	if (AsyncState != I2C_ASYNC_IDLE)
+	{
+		return I2C_Err_Busy;
+	}
+
 	// Skip any writes until the I2C bus is in a known state.
 	if (IsI2C1BusDirty)
 	{
@@ -655,16 +749,19 @@ int I2C1_M_Write(uint8_t DevAddr, uint8_t SubAddr, uint16_t ByteCnt, uint8_t *bu
 		goto FailureExit;
 	}
 
-	// Send the I2C target device register address.
-	if (I2C1_M_WriteByte(SubAddr) != I2C_ACK)
+	// Send the header bytes (ex: the I2C target device register address).
+	unsigned int i=0;
+	for (i=0; i < HdrCnt; i++)
 	{
-		DEBUG_printf("ERROR: Failed to address target I2C device register on write.\r\n");
-		I2C1_M_Stop();
-		goto FailureExit;
+		if (I2C1_M_WriteByte(header[i]) != I2C_ACK)
+		{
+			DEBUG_printf("ERROR: Failed to write header byte %d to I2C device.\r\n", i);
+			I2C1_M_Stop();
+			goto FailureExit;
+		}
 	}
 	
 	// Write each of the buffer's bytes to the target.
-	unsigned int i=0;
 	for (i=0; i < ByteCnt; i++)
 	{
 		if (I2C1_M_WriteByte(buffer[i]) != I2C_ACK)
@@ -756,3 +853,171 @@ int I2C1_M_WriteByte(uint8_t cData)
 	// Otherwise the target device responded with an ACK.
 	return I2C_ACK;
 }
+
+
+// Ends the interrupt-driven transfer and notifies the caller.
+//*******************************************************************************
+static void I2C1_M_AsyncFinish(int status)
+{
+	IEC1bits.MI2C1IE = 0;
+
+	if (status != I2C_OK)
+	{
+		// I2C bus needs to be initialized to a known good state.
+		SetI2C1BusDirty;
+	}
+
+	// Mark idle before calling back so the callback can start the next transfer.
+	AsyncState = I2C_ASYNC_IDLE;
+
+	if (AsyncCallback != NULL)
+	{
+		AsyncCallback(status);
+	}
+}
+
+
+// Starts an interrupt-driven write of a header followed by the data provided in
+// buffer to target address (see I2C1_M_WriteEx()).  Returns as soon as the START
+// has been issued; the rest of the transfer is driven by I2C1_M_AsyncInterrupt()
+// and callback is called from interrupt context once the STOP completes.
+//
+// Header and buffer must remain valid until the callback is called.
+//
+// Return Values:
+//	I2C_OK			Transfer started, callback will report the outcome
+//	I2C_Err_Busy
+//	I2C_Err_BusDirty
+//	I2C_Err_CommFail
+//*******************************************************************************
+int I2C1_M_WriteAsync(uint8_t DevAddr, uint16_t HdrCnt, uint8_t *header, uint16_t ByteCnt, uint8_t *buffer, I2C_AsyncCallback callback)
+{
+	if (AsyncState != I2C_ASYNC_IDLE)
+	{
+		return I2C_Err_Busy;
+	}
+
+	// Skip any writes until the I2C bus is in a known state.
+	if (IsI2C1BusDirty)
+	{
+		DEBUG_printf("WARN: I2C async write request made on an uninitialized bus.\r\n");
+		return I2C_Err_BusDirty;
+	}
+
+	// I2C master must be in idle mode.
+	if ((I2C1CON & 0x1F) != 0)
+	{
+		DEBUG_printf("ERROR: I2C controller isn\'t in idle mode when starting async write.\r\n");
+		SetI2C1BusDirty;
+		return I2C_Err_CommFail;
+	}
+
+	AsyncSlaveAddr = (DevAddr << 1) | 0;		// Write bit.
+	AsyncHeader    = header;
+	AsyncHdrCnt    = HdrCnt;
+	AsyncBuffer    = buffer;
+	AsyncByteCnt   = ByteCnt;
+	AsyncIndex     = 0;
+	AsyncResult    = I2C_OK;
+	AsyncCallback  = callback;
+	AsyncState     = I2C_ASYNC_START;
+
+	// Each completed START, byte and STOP raises the master interrupt.
+	IFS1bits.MI2C1IF = 0;
+	IEC1bits.MI2C1IE = 1;
+
+	// Initiate the start condition.
+	I2C1CONbits.SEN = 1;
+
+	return I2C_OK;
+}
+
+
+// Returns true while an interrupt-driven transfer owns the bus.
+//*******************************************************************************
+bool I2C1_M_IsAsyncBusy(void)
+{
+	return (AsyncState != I2C_ASYNC_IDLE);
+}
+
+
+// Abandons an interrupt-driven transfer that has stopped making progress (ex: SCL
+// held low so no further interrupts arrive).  The callback is not called and the
+// bus is marked dirty so I2C1_M_Poll() will reset it.
+//*******************************************************************************
+void I2C1_M_CancelAsync(void)
+{
+	IEC1bits.MI2C1IE = 0;
+
+	if (AsyncState != I2C_ASYNC_IDLE)
+	{
+		DEBUG_printf("WARN: I2C async write cancelled.\r\n");
+		I2C1_M_ClearErrors();
+		SetI2C1BusDirty;
+		AsyncState = I2C_ASYNC_IDLE;
+	}
+}
+
+
+// Advances the interrupt-driven transfer.  Must be called from the MI2C1
+// interrupt handler after clearing the interrupt flag.
+//*******************************************************************************
+void I2C1_M_AsyncInterrupt(void)
+{
+	// Check for master bus collision.
+	if (I2C1STATbits.BCL == 1)
+	{
+		DEBUG_printf("ERROR: I2C master bus collision during async write.\r\n");
+
+		// Cear the master bus collision to regain control of the I2C bus.  Note that
+		// clearing BCL requires disabling-enabling the I2C controller.
+		I2C1CONbits.SEN = 0;
+		I2C1STATbits.BCL = 0;
+		I2C1CONbits.I2CEN = 0;
+		Nop();
+		I2C1CONbits.I2CEN = 1;
+		I2C1_M_AsyncFinish(I2C_Err_CommFail);
+		return;
+	}
+
+	switch (AsyncState)
+	{
+	case I2C_ASYNC_START:
+		// START complete, address the target.
+		AsyncState = I2C_ASYNC_WRITE;
+		I2C1TRN = AsyncSlaveAddr;
+		break;
+
+	case I2C_ASYNC_WRITE:
+		// Byte sent.  A NAK ends the transfer early (still close the transaction).
+		if (I2C1STATbits.ACKSTAT == 1)
+		{
+			DEBUG_printf("ERROR: Received I2C NAK indication on async write byte %d.\r\n", AsyncIndex);
+			AsyncResult = I2C_Err_CommFail;
+		}
+		else if (AsyncIndex < AsyncHdrCnt)
+		{
+			I2C1TRN = AsyncHeader[AsyncIndex++];
+			break;
+		}
+		else if (AsyncIndex < (AsyncHdrCnt + AsyncByteCnt))
+		{
+			I2C1TRN = AsyncBuffer[AsyncIndex++ - AsyncHdrCnt];
+			break;
+		}
+
+		// Send a STOP message and close the I2C transaction.
+		AsyncState = I2C_ASYNC_STOP;
+		I2C1CONbits.PEN = 1;
+		break;
+
+	case I2C_ASYNC_STOP:
+		I2C1_M_AsyncFinish(AsyncResult);
+		break;
+
+	default:
+		// Spurious interrupt, nothing in progress.
+		IEC1bits.MI2C1IE = 0;
+		break;
+	}
+}
@@ -22,6 +22,12 @@
 #define I2C_Err_TimeoutHW	-101	//Timeout, unknown reason
 #define I2C_Err_CommFail	-102	//General communications failure
 #define I2C_Err_BadAddr		-103	//Bad device address or device stopped responding
+#define I2C_Err_Busy		-104	//Interrupt-driven transfer in progress, try again once it completes
+
+
+//--------------------Types--------------------
+// Completion callback for interrupt-driven transfers (called from the MI2C1 interrupt).
+typedef void (*I2C_AsyncCallback)(int status);
 
 
 //--------------------Variables--------------------
@@ -32,10 +38,17 @@ extern uint16_t I2Cflags;
 void I2C_Initialize(void);
 void I2C_ModuleStart(void);
 int  I2C1_M_Poll(uint8_t);
+int  I2C1_M_Recover(void);
 int  I2C1_M_Read(uint8_t, uint8_t, uint16_t, uint8_t *);
+int  I2C1_M_ReadEx(uint8_t, uint16_t, uint8_t *, uint16_t, uint8_t *);
 int  I2C1_M_ReadByte(uint8_t);
 int  I2C1_M_Write(uint8_t, uint8_t, uint16_t, uint8_t *);
+int  I2C1_M_WriteEx(uint8_t, uint16_t, uint8_t *, uint16_t, uint8_t *);
 int  I2C1_M_WriteByte(uint8_t);
+int  I2C1_M_WriteAsync(uint8_t, uint16_t, uint8_t *, uint16_t, uint8_t *, I2C_AsyncCallback);
+bool I2C1_M_IsAsyncBusy(void);
+void I2C1_M_CancelAsync(void);
+void I2C1_M_AsyncInterrupt(void);
 
 
 //-------------------Macros-------------------
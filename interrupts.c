@@ -18,6 +18,9 @@
 #include <stdint.h>        /* Includes uint16_t definition */
 #include <stdbool.h>       /* Includes true/false definition */
 
+#include "i2c.h"
+#include "uart.h"
+
 /******************************************************************************/
 /* Interrupt Vector Options                                                   */
 /******************************************************************************/
@@ -155,4 +158,16 @@
 /* Interrupt Routines                                                         */
 /******************************************************************************/
 
-/* TODO Add interrupt routine code here. */
+/* I2C1 master events (START, byte, STOP complete) drive asynchronous writes. */
+void __attribute__((interrupt,auto_psv)) _MI2C1Interrupt(void)
+{
+    IFS1bits.MI2C1IF = 0;
+    I2C1_M_AsyncInterrupt();
+}
+
+/* UART1 transmit buffer has room; refill it from the transmit queue. */
+void __attribute__((interrupt,auto_psv)) _U1TXInterrupt(void)
+{
+    IFS0bits.U1TXIF = 0;
+    UART1_TxInterrupt();
+}
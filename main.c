@@ -24,7 +24,12 @@
 #include <libpic30.h>
 
 #include "i2c.h"
+#include "uart.h"
 #include "sh1106_panel.h"
+#include "sh1106_displaylist.h"
+#include "sh1106_mirror.h"
+#include "framepacer.h"
+#include "circle_benchmark.h"
 #include "font.h"
 #include "Fonts/FreeSans9pt7b.h"
 
@@ -36,7 +41,36 @@
 /* Main Program                                                               */
 /******************************************************************************/
 
-uint8_t buffer[SH1106_BUFFER_LINE_WIDTH_BYTES * SH1106_BUFFER_NUM_LINES];
+#if SH1106_USE_FRAMEBUFFER
+uint8_t buffer[SH1106_BUFFER_SIZE_BYTES];
+uint8_t backBuffer[SH1106_BUFFER_SIZE_BYTES];
+#else
+uint8_t strip[SH1106_PAGE_WIDTH_BYTES];
+SH1106_DLCommand displayList[16];
+#endif
+
+// Radar sweep position.
+static const uint8_t cx = 90;
+static const uint8_t cy = 32;
+static const uint8_t cr = 25;
+static uint8_t tx = 90;
+static uint8_t ty = 32;
+
+static void DrawName(void)
+{
+    SetCursor(0, 0);
+    WriteChar('\n');
+    WriteChar('M');
+    WriteChar('a');
+    WriteChar('y');
+    WriteChar('a');
+    WriteChar('\n');
+    WriteChar('G');
+    WriteChar('l');
+    WriteChar('a');
+    WriteChar('u');
+    WriteChar('m');
+}
 
 int16_t main(void)
 {
@@ -51,39 +85,70 @@ int16_t main(void)
     I2C_ModuleStart();
     I2C1_M_Poll(I2C_OLED_ADDRESS);
     
-    // Configure display.
-    SH1106_InitDisplay();
+    // Configure display.  After a watchdog or other reset the panel is usually
+    // still running and only needs its settings checked; settings made before the
+    // first flush are folded in, so an inverted panel stays inverted.
+    SH1106_WarmStart();
     SH1106_InvertDisplay(true);
     SH1106_ClearDisplay();
-    
+
     SetFont(&FreeSans9pt7b);
-    WriteChar('\n');
-    WriteChar('M');
-    WriteChar('a');
-    WriteChar('y');
-    WriteChar('a');
-    WriteChar('\n');
-    WriteChar('G');
-    WriteChar('l');
-    WriteChar('a');
-    WriteChar('u');
-    WriteChar('m');
 
-    uint8_t cx = 90;
-    uint8_t cy = 32;
-    uint8_t cr = 25;
+#if SH1106_USE_FRAMEBUFFER
+    // Draw into a second buffer so rendering can overlap the background flush.
+    SH1106_SetBackBuffer(backBuffer);
+    
+    DrawName();
+    SH1106_DrawCircle(cx, cy, cr, WHITE, false);
+#else
+    // Without a frame buffer the scene is kept as a display list.  The static part
+    // is recorded once and the sweep line is replaced each time around the loop;
+    // only the pages it touches are redrawn.
+    SH1106_DL_Init(displayList, (sizeof(displayList) / sizeof(displayList[0])));
+    SH1106_DL_Begin();
+    DrawName();
     SH1106_DrawCircle(cx, cy, cr, WHITE, false);
+    SH1106_DL_End();
+
+    uint8_t sceneCount = SH1106_DL_Count();
+#endif
 
     double rads = 0;
     uint16_t color = WHITE;
 
+    // Mirror the panel to the serial port for remote viewing (tools/sh1106_mirror.py).
+    UART1_Initialize(19200);
+
+#if CIRCLE_BENCHMARK
+    CircleBenchmark_Run();
+#endif
+
+    SH1106_Mirror_Start();
+
+    // Run the sweep at a steady 50 frames per second.
+    FramePacer_Init(50);
+
     while(true)
     {
-        uint8_t tx = (cx + (cr-1) * cos(rads));
-        uint8_t ty = (cy + (cr-1) * sin(rads));
+        FramePacer_BeginFrame();
+
+        tx = (cx + (cr-1) * cos(rads));
+        ty = (cy + (cr-1) * sin(rads));
+
+#if SH1106_USE_FRAMEBUFFER
         SH1106_DrawLine(cx, cy, tx, ty, color);
-        SH1106_Display();
-        __delay_ms(5);
+
+        // Flip and send the changes in the background.  If the last frame is still
+        // on the wire this frame's changes stay in the back buffer and go out with
+        // the next one.
+        FramePacer_Present();
+#else
+        SH1106_DL_Truncate(sceneCount);
+        SH1106_DL_Begin();
+        SH1106_DrawLine(cx, cy, tx, ty, WHITE);
+        SH1106_DL_End();
+        SH1106_DL_Render(strip);
+#endif
 
         rads += (6.0 * ONE_RADIAN);
         if (rads > TWO_PI)
@@ -92,7 +157,16 @@ int16_t main(void)
             color = (color == WHITE ? BLACK : WHITE);
         }
 
-        // Regularly check I2C sensors.
-        I2C1_M_Poll(I2C_OLED_ADDRESS);
+        // Send a page of the mirror if the serial port has room.
+        SH1106_Mirror_Service();
+
+        // Regularly check I2C sensors (the bus is shared with the display flush).
+        if (!SH1106_IsFlushBusy())
+        {
+            I2C1_M_Poll(I2C_OLED_ADDRESS);
+        }
+
+        // Wait out the rest of the frame.
+        FramePacer_EndFrame();
     }
 }
@@ -57,17 +57,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=configuration_bits.c interrupts.c main.c system.c traps.c user.c i2c.c delay.c sh1106_panel.c font.c
+SOURCEFILES_QUOTED_IF_SPACED=configuration_bits.c interrupts.c main.c system.c traps.c user.c i2c.c delay.c sh1106_panel.c font.c sh1106_displaylist.c framepacer.c sh1106_grey.c sh1106_mirror.c uart.c circle_benchmark.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/interrupts.o ${OBJECTDIR}/main.o ${OBJECTDIR}/system.o ${OBJECTDIR}/traps.o ${OBJECTDIR}/user.o ${OBJECTDIR}/i2c.o ${OBJECTDIR}/delay.o ${OBJECTDIR}/sh1106_panel.o ${OBJECTDIR}/font.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/configuration_bits.o.d ${OBJECTDIR}/interrupts.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/system.o.d ${OBJECTDIR}/traps.o.d ${OBJECTDIR}/user.o.d ${OBJECTDIR}/i2c.o.d ${OBJECTDIR}/delay.o.d ${OBJECTDIR}/sh1106_panel.o.d ${OBJECTDIR}/font.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/interrupts.o ${OBJECTDIR}/main.o ${OBJECTDIR}/system.o ${OBJECTDIR}/traps.o ${OBJECTDIR}/user.o ${OBJECTDIR}/i2c.o ${OBJECTDIR}/delay.o ${OBJECTDIR}/sh1106_panel.o ${OBJECTDIR}/font.o ${OBJECTDIR}/sh1106_displaylist.o ${OBJECTDIR}/framepacer.o ${OBJECTDIR}/sh1106_grey.o ${OBJECTDIR}/sh1106_mirror.o ${OBJECTDIR}/uart.o ${OBJECTDIR}/circle_benchmark.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/configuration_bits.o.d ${OBJECTDIR}/interrupts.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/system.o.d ${OBJECTDIR}/traps.o.d ${OBJECTDIR}/user.o.d ${OBJECTDIR}/i2c.o.d ${OBJECTDIR}/delay.o.d ${OBJECTDIR}/sh1106_panel.o.d ${OBJECTDIR}/font.o.d ${OBJECTDIR}/sh1106_displaylist.o.d ${OBJECTDIR}/framepacer.o.d ${OBJECTDIR}/sh1106_grey.o.d ${OBJECTDIR}/sh1106_mirror.o.d ${OBJECTDIR}/uart.o.d ${OBJECTDIR}/circle_benchmark.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/interrupts.o ${OBJECTDIR}/main.o ${OBJECTDIR}/system.o ${OBJECTDIR}/traps.o ${OBJECTDIR}/user.o ${OBJECTDIR}/i2c.o ${OBJECTDIR}/delay.o ${OBJECTDIR}/sh1106_panel.o ${OBJECTDIR}/font.o
+OBJECTFILES=${OBJECTDIR}/configuration_bits.o ${OBJECTDIR}/interrupts.o ${OBJECTDIR}/main.o ${OBJECTDIR}/system.o ${OBJECTDIR}/traps.o ${OBJECTDIR}/user.o ${OBJECTDIR}/i2c.o ${OBJECTDIR}/delay.o ${OBJECTDIR}/sh1106_panel.o ${OBJECTDIR}/font.o ${OBJECTDIR}/sh1106_displaylist.o ${OBJECTDIR}/framepacer.o ${OBJECTDIR}/sh1106_grey.o ${OBJECTDIR}/sh1106_mirror.o ${OBJECTDIR}/uart.o ${OBJECTDIR}/circle_benchmark.o
 
 # Source Files
-SOURCEFILES=configuration_bits.c interrupts.c main.c system.c traps.c user.c i2c.c delay.c sh1106_panel.c font.c
+SOURCEFILES=configuration_bits.c interrupts.c main.c system.c traps.c user.c i2c.c delay.c sh1106_panel.c font.c sh1106_displaylist.c framepacer.c sh1106_grey.c sh1106_mirror.c uart.c circle_benchmark.c
 
 
 
@@ -155,6 +155,42 @@ ${OBJECTDIR}/font.o: font.c  .generated_files/7094037d91557b44ca9ca234dcb64446a3
 	@${RM} ${OBJECTDIR}/font.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE)  font.c  -o ${OBJECTDIR}/font.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/font.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
 	
+${OBJECTDIR}/sh1106_displaylist.o: sh1106_displaylist.c  .generated_files/81c24034a73097a4607e95379ea5cfc81a001b6b.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sh1106_displaylist.o.d 
+	@${RM} ${OBJECTDIR}/sh1106_displaylist.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sh1106_displaylist.c  -o ${OBJECTDIR}/sh1106_displaylist.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sh1106_displaylist.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/framepacer.o: framepacer.c  .generated_files/ab232a836bbc3b3431bc944b672d37dba1ea36b4.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/framepacer.o.d 
+	@${RM} ${OBJECTDIR}/framepacer.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  framepacer.c  -o ${OBJECTDIR}/framepacer.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/framepacer.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/sh1106_grey.o: sh1106_grey.c  .generated_files/24b4631aff2a722a635703a63851a8a8e1f5cba8.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sh1106_grey.o.d 
+	@${RM} ${OBJECTDIR}/sh1106_grey.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sh1106_grey.c  -o ${OBJECTDIR}/sh1106_grey.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sh1106_grey.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/sh1106_mirror.o: sh1106_mirror.c  .generated_files/82a6a049e5f1861bf4079e647914e8748dacd7f8.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sh1106_mirror.o.d 
+	@${RM} ${OBJECTDIR}/sh1106_mirror.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sh1106_mirror.c  -o ${OBJECTDIR}/sh1106_mirror.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sh1106_mirror.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/uart.o: uart.c  .generated_files/34e2ccdb0b4ad42300e902574514f0ae061b60e0.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/uart.o.d 
+	@${RM} ${OBJECTDIR}/uart.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  uart.c  -o ${OBJECTDIR}/uart.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/uart.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/circle_benchmark.o: circle_benchmark.c  .generated_files/42802d62a513570cb85373e04ce9f1a9970fd7b5.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/circle_benchmark.o.d 
+	@${RM} ${OBJECTDIR}/circle_benchmark.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  circle_benchmark.c  -o ${OBJECTDIR}/circle_benchmark.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/circle_benchmark.o.d"      -g -D__DEBUG -D__MPLAB_DEBUGGER_PK3=1    -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
 else
 ${OBJECTDIR}/configuration_bits.o: configuration_bits.c  .generated_files/6a83b15bc7257c08f0c04459fc931a9504483b56.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
 	@${MKDIR} "${OBJECTDIR}" 
@@ -216,6 +252,42 @@ ${OBJECTDIR}/font.o: font.c  .generated_files/732e72f7d4e81b17e708ad0401c7970313
 	@${RM} ${OBJECTDIR}/font.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE)  font.c  -o ${OBJECTDIR}/font.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/font.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
 	
+${OBJECTDIR}/sh1106_displaylist.o: sh1106_displaylist.c  .generated_files/3f5deeb4d5a558dad2cda751ac8da83e63fba929.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sh1106_displaylist.o.d 
+	@${RM} ${OBJECTDIR}/sh1106_displaylist.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sh1106_displaylist.c  -o ${OBJECTDIR}/sh1106_displaylist.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sh1106_displaylist.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/framepacer.o: framepacer.c  .generated_files/9f01fc08a152cee44ad175d24e92c7434fbaa63f.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/framepacer.o.d 
+	@${RM} ${OBJECTDIR}/framepacer.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  framepacer.c  -o ${OBJECTDIR}/framepacer.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/framepacer.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/sh1106_grey.o: sh1106_grey.c  .generated_files/8029d4c131b2a0af91107f89673ed06a15904688.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sh1106_grey.o.d 
+	@${RM} ${OBJECTDIR}/sh1106_grey.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sh1106_grey.c  -o ${OBJECTDIR}/sh1106_grey.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sh1106_grey.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/sh1106_mirror.o: sh1106_mirror.c  .generated_files/fc80f7d3d7c1618f64d27d087826ec5a25bfc6fb.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/sh1106_mirror.o.d 
+	@${RM} ${OBJECTDIR}/sh1106_mirror.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  sh1106_mirror.c  -o ${OBJECTDIR}/sh1106_mirror.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/sh1106_mirror.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/uart.o: uart.c  .generated_files/31b4d1f117391b59180925f62a655cc706552874.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/uart.o.d 
+	@${RM} ${OBJECTDIR}/uart.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  uart.c  -o ${OBJECTDIR}/uart.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/uart.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
+${OBJECTDIR}/circle_benchmark.o: circle_benchmark.c  .generated_files/2a6f1c26d42b74d342f6aedba5e5482e4a7c6c3c.flag .generated_files/3a182ac3e8b92e4004fdec2790250c51f5614a24.flag
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/circle_benchmark.o.d 
+	@${RM} ${OBJECTDIR}/circle_benchmark.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE)  circle_benchmark.c  -o ${OBJECTDIR}/circle_benchmark.o  -c -mcpu=$(MP_PROCESSOR_OPTION)  -MP -MMD -MF "${OBJECTDIR}/circle_benchmark.o.d"        -g -omf=elf -DXPRJ_XC16_24FJ256GA110=$(CND_CONF)  -no-legacy-libc  $(COMPARISON_BUILD)  -O0 -msmart-io=1 -Wall -msfr-warn=off    -mdfp="${DFP_DIR}/xc16"
+	
 endif
 
 # ------------------------------------------------------------------------------------
@@ -0,0 +1,354 @@
+/*
+ * File:   sh1106_displaylist.c
+ * Author: jeffglaum
+ *
+ * Created on January 20, 2024, 10:05 AM
+ */
+
+// Retained display list.  While recording, SH1106_DrawLine(), SH1106_DrawRect(),
+// SH1106_DrawCircle(), SH1106_DrawTriangle(), SH1106_DrawPolygon() and DrawChar()
+// append a command to the list instead of drawing.  The list is then rasterized
+// a page at a time, skipping commands whose bounding box doesn't reach the page,
+// so a scene can be redrawn from a single page strip and only the pages touched
+// by a change need redrawing.
+
+#include "xc.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "i2c.h"
+#include "sh1106_panel.h"
+#include "sh1106_displaylist.h"
+#include "font.h"
+
+// Command storage supplied by SH1106_DL_Init().
+static SH1106_DLCommand *dl_list = NULL;
+static uint8_t dl_capacity = 0;
+static uint8_t dl_count = 0;
+
+static bool dl_recording = false;
+static bool dl_overflow = false;
+
+// Pages (bit 0 is page 0) whose rasterized contents no longer match the list.
+static uint8_t dl_stale = 0xFF;
+
+
+// Mask of the pages covering lines y0-y1 (inclusive).
+static uint8_t SH1106_DL_PageMask(uint8_t y0, uint8_t y1)
+{
+    return (0xFF << (y0 / NUM_LINES_IN_A_PAGE)) & (0xFF >> ((SH1106_NUM_PAGES - 1) - (y1 / NUM_LINES_IN_A_PAGE)));
+}
+
+// Append a command with the given bounding box, clipped to the display.  Returns
+// NULL if nothing needs recording (the box is off the display) or the list is full.
+static SH1106_DLCommand *SH1106_DL_Add(uint8_t op, uint16_t color, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    SH1106_DLCommand *cmd;
+
+    if (x0 < 0) { x0 = 0; }
+    if (y0 < 0) { y0 = 0; }
+    if (x1 >= SH1106_DISPLAYABLE_WIDTH_PIXELS)  { x1 = SH1106_DISPLAYABLE_WIDTH_PIXELS - 1; }
+    if (y1 >= SH1106_DISPLAYABLE_HEIGHT_PIXELS) { y1 = SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1; }
+    if ((x0 > x1) || (y0 > y1))
+    {
+        return NULL;
+    }
+
+    if (dl_count >= dl_capacity)
+    {
+        dl_overflow = true;
+        return NULL;
+    }
+
+    cmd = &dl_list[dl_count++];
+    cmd->op    = op;
+    cmd->color = color;
+    cmd->x0    = x0;
+    cmd->y0    = y0;
+    cmd->x1    = x1;
+    cmd->y1    = y1;
+
+    dl_stale |= SH1106_DL_PageMask(y0, y1);
+
+    return cmd;
+}
+
+// Use the given array of capacity commands to hold the display list.  The list
+// starts out empty.
+void SH1106_DL_Init(SH1106_DLCommand *list, uint8_t capacity)
+{
+    dl_list     = list;
+    dl_capacity = capacity;
+    dl_recording = false;
+    SH1106_DL_Clear();
+}
+
+// Empty the list.  Every page needs redrawing afterwards.
+void SH1106_DL_Clear(void)
+{
+    dl_count    = 0;
+    dl_overflow = false;
+    dl_stale    = 0xFF;
+}
+
+// Start appending drawing calls to the list (after anything already in it).
+void SH1106_DL_Begin(void)
+{
+    dl_recording = (dl_list != NULL);
+    dl_overflow  = false;
+}
+
+// Stop recording.  Returns false if any command was dropped because the list
+// was full.
+bool SH1106_DL_End(void)
+{
+    dl_recording = false;
+
+    return !dl_overflow;
+}
+
+bool SH1106_DL_IsRecording(void)
+{
+    return dl_recording;
+}
+
+uint8_t SH1106_DL_Count(void)
+{
+    return dl_count;
+}
+
+// Drop the commands from index count onwards (ex: to replace the moving part of a
+// scene recorded last).  The pages they covered need redrawing.
+void SH1106_DL_Truncate(uint8_t count)
+{
+    while (dl_count > count)
+    {
+        SH1106_DLCommand *cmd = &dl_list[--dl_count];
+
+        dl_stale |= SH1106_DL_PageMask(cmd->y0, cmd->y1);
+    }
+}
+
+// Force the pages covering h lines from line y to be redrawn on the next render.
+void SH1106_DL_Invalidate(int16_t y, int16_t h)
+{
+    if (y < 0) { h += y; y = 0; }
+    if ((y + h) > SH1106_DISPLAYABLE_HEIGHT_PIXELS) { h = SH1106_DISPLAYABLE_HEIGHT_PIXELS - y; }
+    if (h <= 0) { return; }
+
+    dl_stale |= SH1106_DL_PageMask(y, (y + h - 1));
+}
+
+uint8_t SH1106_DL_StalePages(void)
+{
+    return dl_stale;
+}
+
+// Draw the commands that touch the given page, in the order they were recorded.
+// Intended as an SH1106_DrawCallback for SH1106_RenderPages() but usable with any
+// clipping; commands outside the page are skipped without being drawn.
+void SH1106_DL_DrawPage(uint8_t page)
+{
+    const GFXfont *font = GetFont();
+    bool recording = dl_recording;
+    uint8_t i;
+
+    dl_recording = false;
+
+    for (i = 0; i < dl_count; i++)
+    {
+        SH1106_DLCommand *cmd = &dl_list[i];
+
+        if ((page < (cmd->y0 / NUM_LINES_IN_A_PAGE)) || (page > (cmd->y1 / NUM_LINES_IN_A_PAGE)))
+        {
+            continue;
+        }
+
+        switch (cmd->op)
+        {
+            case SH1106_DL_LINE:
+                SH1106_DrawLine(cmd->u.arg[0], cmd->u.arg[1], cmd->u.arg[2], cmd->u.arg[3], cmd->color);
+                break;
+            case SH1106_DL_RECT:
+            case SH1106_DL_FILLRECT:
+                SH1106_DrawRect(cmd->u.arg[0], cmd->u.arg[1], cmd->u.arg[2], cmd->u.arg[3], cmd->color,
+                                (cmd->op == SH1106_DL_FILLRECT));
+                break;
+            case SH1106_DL_CIRCLE:
+            case SH1106_DL_FILLCIRCLE:
+                SH1106_DrawCircle(cmd->u.arg[0], cmd->u.arg[1], cmd->u.arg[2], cmd->color,
+                                  (cmd->op == SH1106_DL_FILLCIRCLE));
+                break;
+            case SH1106_DL_TRIANGLE:
+            case SH1106_DL_FILLTRIANGLE:
+                SH1106_DrawTriangle(cmd->u.arg[0], cmd->u.arg[1], cmd->u.arg[2], cmd->u.arg[3],
+                                    cmd->u.arg[4], cmd->u.arg[5], cmd->color,
+                                    (cmd->op == SH1106_DL_FILLTRIANGLE));
+                break;
+            case SH1106_DL_POLYGON:
+                SH1106_DrawPolygon(cmd->u.poly.points, cmd->u.poly.count, cmd->color, cmd->u.poly.mode);
+                break;
+            case SH1106_DL_CHAR:
+                SetFont(cmd->u.ch.font);
+                DrawChar(cmd->u.ch.x, cmd->u.ch.y, cmd->u.ch.c, cmd->color, cmd->color,
+                         (cmd->u.ch.size & 0x0F), (cmd->u.ch.size >> 4));
+                break;
+        }
+    }
+
+    SetFont(font);
+    dl_recording = recording;
+}
+
+// Redraw the pages that changed since the last render.  With a page strip
+// (SH1106_PAGE_WIDTH_BYTES long) they're sent straight to the panel; with strip
+// NULL they're redrawn in the frame buffer for the next flush.  Pages that fail to
+// send stay stale.
+int SH1106_DL_Render(uint8_t *strip)
+{
+    uint8_t pages = dl_stale;
+    int retval;
+
+    if (pages == 0)
+    {
+        return I2C_OK;
+    }
+
+    dl_stale = 0;
+    retval = SH1106_RenderPages(strip, SH1106_DL_DrawPage, pages);
+    if (retval != I2C_OK)
+    {
+        dl_stale |= pages;
+    }
+
+    return retval;
+}
+
+void SH1106_DL_AddLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    SH1106_DLCommand *cmd = SH1106_DL_Add(SH1106_DL_LINE, color,
+                                          ((x0 < x1) ? x0 : x1), ((y0 < y1) ? y0 : y1),
+                                          ((x0 > x1) ? x0 : x1), ((y0 > y1) ? y0 : y1));
+
+    if (cmd != NULL)
+    {
+        cmd->u.arg[0] = x0;
+        cmd->u.arg[1] = y0;
+        cmd->u.arg[2] = x1;
+        cmd->u.arg[3] = y1;
+    }
+}
+
+void SH1106_DL_AddRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color, bool fill)
+{
+    // An outline also covers its right and bottom edge lines.
+    int16_t x1 = (int16_t)x + w - (fill ? 1 : 0);
+    int16_t y1 = (int16_t)y + h - (fill ? 1 : 0);
+    SH1106_DLCommand *cmd = SH1106_DL_Add((fill ? SH1106_DL_FILLRECT : SH1106_DL_RECT), color, x, y, x1, y1);
+
+    if (cmd != NULL)
+    {
+        cmd->u.arg[0] = x;
+        cmd->u.arg[1] = y;
+        cmd->u.arg[2] = w;
+        cmd->u.arg[3] = h;
+    }
+}
+
+void SH1106_DL_AddCircle(uint8_t x, uint8_t y, uint8_t r, uint16_t color, bool fill)
+{
+    SH1106_DLCommand *cmd = SH1106_DL_Add((fill ? SH1106_DL_FILLCIRCLE : SH1106_DL_CIRCLE), color,
+                                          ((int16_t)x - r), ((int16_t)y - r), ((int16_t)x + r), ((int16_t)y + r));
+
+    if (cmd != NULL)
+    {
+        cmd->u.arg[0] = x;
+        cmd->u.arg[1] = y;
+        cmd->u.arg[2] = r;
+    }
+}
+
+void SH1106_DL_AddTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool fill)
+{
+    int16_t xmin = x0, ymin = y0, xmax = x0, ymax = y0;
+    SH1106_DLCommand *cmd;
+
+    if (x1 < xmin) { xmin = x1; }
+    if (x1 > xmax) { xmax = x1; }
+    if (x2 < xmin) { xmin = x2; }
+    if (x2 > xmax) { xmax = x2; }
+    if (y1 < ymin) { ymin = y1; }
+    if (y1 > ymax) { ymax = y1; }
+    if (y2 < ymin) { ymin = y2; }
+    if (y2 > ymax) { ymax = y2; }
+
+    cmd = SH1106_DL_Add((fill ? SH1106_DL_FILLTRIANGLE : SH1106_DL_TRIANGLE), color, xmin, ymin, xmax, ymax);
+    if (cmd != NULL)
+    {
+        cmd->u.arg[0] = x0;
+        cmd->u.arg[1] = y0;
+        cmd->u.arg[2] = x1;
+        cmd->u.arg[3] = y1;
+        cmd->u.arg[4] = x2;
+        cmd->u.arg[5] = y2;
+    }
+}
+
+// The points aren't copied, so they must stay valid while the list is in use.
+void SH1106_DL_AddPolygon(const SH1106_Point *points, uint8_t count, uint16_t color, uint8_t mode)
+{
+    int16_t xmin, ymin, xmax, ymax;
+    SH1106_DLCommand *cmd;
+    uint8_t i;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    // SH1106_DrawPolygon() wouldn't draw a fill this big, so don't record it.
+    if ((mode != SH1106_POLY_OUTLINE) && (count > SH1106_POLY_MAX_POINTS))
+    {
+        return;
+    }
+
+    xmin = xmax = points[0].x;
+    ymin = ymax = points[0].y;
+    for (i = 1; i < count; i++)
+    {
+        if (points[i].x < xmin) { xmin = points[i].x; }
+        if (points[i].x > xmax) { xmax = points[i].x; }
+        if (points[i].y < ymin) { ymin = points[i].y; }
+        if (points[i].y > ymax) { ymax = points[i].y; }
+    }
+
+    cmd = SH1106_DL_Add(SH1106_DL_POLYGON, color, xmin, ymin, xmax, ymax);
+    if (cmd != NULL)
+    {
+        cmd->u.poly.points = points;
+        cmd->u.poly.count  = count;
+        cmd->u.poly.mode   = mode;
+    }
+}
+
+void SH1106_DL_AddChar(const GFXfont *font, int16_t x, int16_t y, unsigned char c, uint16_t color, uint8_t size_x, uint8_t size_y)
+{
+    const GFXglyph *glyph = &font->glyph[c - font->first];
+    SH1106_DLCommand *cmd;
+
+    // Same extent DrawChar() covers.
+    cmd = SH1106_DL_Add(SH1106_DL_CHAR, color,
+                        (x + (glyph->xOffset * size_x)), (y + (glyph->yOffset * size_y)),
+                        (x + ((glyph->xOffset + glyph->width) * size_x) - 1),
+                        (y + ((glyph->yOffset + glyph->height) * size_y) - 1));
+
+    if (cmd != NULL)
+    {
+        cmd->u.ch.font = font;
+        cmd->u.ch.x    = x;
+        cmd->u.ch.y    = y;
+        cmd->u.ch.c    = c;
+        cmd->u.ch.size = (size_x & 0x0F) | (size_y << 4);
+    }
+}
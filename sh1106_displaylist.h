@@ -0,0 +1,64 @@
+#pragma once
+
+// Retained display list for the SH1106 panel.
+// 2024-01-20 Jeff Glaum
+
+#include <xc.h> // include processor files - each processor file is guarded.
+
+#include <stdbool.h>
+
+#include "gfxfont.h"
+#include "sh1106_panel.h"
+
+// Display list command opcodes.
+#define SH1106_DL_LINE          0
+#define SH1106_DL_RECT          1
+#define SH1106_DL_FILLRECT      2
+#define SH1106_DL_CIRCLE        3
+#define SH1106_DL_FILLCIRCLE    4
+#define SH1106_DL_CHAR          5
+#define SH1106_DL_TRIANGLE      6
+#define SH1106_DL_FILLTRIANGLE  7
+#define SH1106_DL_POLYGON       8
+
+// One recorded drawing call.  The bounding box is clipped to the display and
+// used to skip the command when rasterizing pages it can't touch.
+typedef struct {
+  uint8_t op;               ///< SH1106_DL_* opcode
+  uint8_t color;            ///< WHITE, BLACK or INVERSE
+  uint8_t x0, y0, x1, y1;   ///< Bounding box (inclusive)
+  union {
+    int16_t arg[6];         ///< Shape coordinates, as passed to the draw call
+    struct {
+      const GFXfont *font;  ///< Font selected when the character was drawn
+      int16_t x, y;         ///< Glyph origin
+      uint8_t c;            ///< Character
+      uint8_t size;         ///< Magnification, x in the low nibble, y in the high
+    } ch;
+    struct {
+      const SH1106_Point *points;   ///< Caller's vertices, not a copy
+      uint8_t count;        ///< Number of vertices
+      uint8_t mode;         ///< SH1106_POLY_* mode
+    } poly;
+  } u;
+} SH1106_DLCommand;
+
+void SH1106_DL_Init(SH1106_DLCommand *list, uint8_t capacity);
+void SH1106_DL_Clear(void);
+void SH1106_DL_Begin(void);
+bool SH1106_DL_End(void);
+bool SH1106_DL_IsRecording(void);
+uint8_t SH1106_DL_Count(void);
+void SH1106_DL_Truncate(uint8_t count);
+void SH1106_DL_Invalidate(int16_t y, int16_t h);
+uint8_t SH1106_DL_StalePages(void);
+void SH1106_DL_DrawPage(uint8_t page);
+int  SH1106_DL_Render(uint8_t *strip);
+
+// Recording hooks used by the drawing primitives.
+void SH1106_DL_AddLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+void SH1106_DL_AddRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color, bool fill);
+void SH1106_DL_AddCircle(uint8_t x, uint8_t y, uint8_t r, uint16_t color, bool fill);
+void SH1106_DL_AddTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool fill);
+void SH1106_DL_AddPolygon(const SH1106_Point *points, uint8_t count, uint16_t color, uint8_t mode);
+void SH1106_DL_AddChar(const GFXfont *font, int16_t x, int16_t y, unsigned char c, uint16_t color, uint8_t size_x, uint8_t size_y);
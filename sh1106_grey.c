@@ -0,0 +1,272 @@
+/*
+ * File:   sh1106_grey.c
+ * Author: jeffglaum
+ *
+ * Created on February 3, 2024, 11:20 AM
+ */
+
+// 2-bit greyscale by time multiplexing.  The image is kept as two bitplanes laid
+// out like the frame buffer, drawn with the panel's primitives through
+// SH1106_SetDrawTarget().  SH1106_Grey_Tick(), called at a fixed rate, shows the
+// planes in turn with plane 1 held twice as long as plane 0.  Switching planes
+// only needs the columns where the two planes differ, so each tick sends those
+// (worked out again after drawing) plus anything drawn since the last tick.
+//
+// The planes are sent straight to the panel and the frame buffer is left alone;
+// SH1106_Grey_Stop() has it resent.  Don't draw in greyscale while recording a
+// display list.
+
+#include "xc.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "i2c.h"
+#include "sh1106_panel.h"
+#include "sh1106_grey.h"
+
+#define SH1106_GREY_NO_PLANE    0xFF
+
+// Color plane is drawn in for a grey level.
+#define SH1106_GREY_COLOR(level, plane)     ((((level) >> (plane)) & 1) ? WHITE : BLACK)
+
+static uint8_t *grey_planes[2] = { NULL, NULL };
+
+// Plane the panel shows, and the tick within the grey cycle.
+static uint8_t grey_shown = SH1106_GREY_NO_PLANE;
+static uint8_t grey_tick = 0;
+
+// Columns (inclusive) of each page drawn since the last tick, and columns where
+// the planes differ.  A page's range is empty when its low column is greater
+// than its high column.
+static uint8_t grey_dirty_lo[SH1106_NUM_PAGES] = { [0 ... (SH1106_NUM_PAGES - 1)] = 0xFF };
+static uint8_t grey_dirty_hi[SH1106_NUM_PAGES];
+static uint8_t grey_diff_lo[SH1106_NUM_PAGES] = { [0 ... (SH1106_NUM_PAGES - 1)] = 0xFF };
+static uint8_t grey_diff_hi[SH1106_NUM_PAGES];
+static bool grey_drawn = false;
+
+
+// Record that the box x0-x1, y0-y1 (inclusive) has been drawn.
+static void SH1106_Grey_MarkDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    uint8_t page;
+
+    if (x0 < 0) { x0 = 0; }
+    if (y0 < 0) { y0 = 0; }
+    if (x1 >= SH1106_DISPLAYABLE_WIDTH_PIXELS)  { x1 = SH1106_DISPLAYABLE_WIDTH_PIXELS - 1; }
+    if (y1 >= SH1106_DISPLAYABLE_HEIGHT_PIXELS) { y1 = SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1; }
+    if ((x0 > x1) || (y0 > y1))
+    {
+        return;
+    }
+
+    for (page = (y0 / NUM_LINES_IN_A_PAGE); page <= (y1 / NUM_LINES_IN_A_PAGE); page++)
+    {
+        if (x0 < grey_dirty_lo[page]) { grey_dirty_lo[page] = x0; }
+        if (x1 > grey_dirty_hi[page]) { grey_dirty_hi[page] = x1; }
+    }
+
+    grey_drawn = true;
+}
+
+// Work out where the planes differ.
+static void SH1106_Grey_Diff(void)
+{
+    uint8_t page, x;
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        const uint8_t *p0 = &grey_planes[0][(uint16_t)page * SH1106_PAGE_WIDTH_BYTES];
+        const uint8_t *p1 = &grey_planes[1][(uint16_t)page * SH1106_PAGE_WIDTH_BYTES];
+
+        grey_diff_lo[page] = 0xFF;
+        grey_diff_hi[page] = 0;
+
+        for (x = 0; x < SH1106_PAGE_WIDTH_BYTES; x++)
+        {
+            if (p0[x] != p1[x])
+            {
+                if (grey_diff_lo[page] == 0xFF) { grey_diff_lo[page] = x; }
+                grey_diff_hi[page] = x;
+            }
+        }
+    }
+}
+
+// Use the given planes (SH1106_BUFFER_SIZE_BYTES long each) for greyscale.  The
+// image starts out black and is sent in full on the first tick.
+void SH1106_Grey_Init(uint8_t *plane0, uint8_t *plane1)
+{
+    grey_planes[0] = plane0;
+    grey_planes[1] = plane1;
+    grey_tick      = 0;
+
+    SH1106_Grey_Clear();
+}
+
+// Stop cycling the planes.  The frame buffer is resent with the next flush.
+void SH1106_Grey_Stop(void)
+{
+    grey_planes[0] = grey_planes[1] = NULL;
+    SH1106_InvalidateDisplay();
+}
+
+void SH1106_Grey_Clear(void)
+{
+    if (grey_planes[0] == NULL)
+    {
+        return;
+    }
+
+    memset(grey_planes[0], 0, SH1106_BUFFER_SIZE_BYTES);
+    memset(grey_planes[1], 0, SH1106_BUFFER_SIZE_BYTES);
+
+    // What the panel shows is unknown, so send everything.
+    grey_shown = SH1106_GREY_NO_PLANE;
+    SH1106_Grey_MarkDirty(0, 0, (SH1106_DISPLAYABLE_WIDTH_PIXELS - 1), (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1));
+}
+
+void SH1106_Grey_DrawPixel(int16_t x, int16_t y, uint8_t level)
+{
+    uint8_t plane;
+
+    if ((grey_planes[0] == NULL) || (x < 0) || (y < 0))
+    {
+        return;
+    }
+
+    for (plane = 0; plane < 2; plane++)
+    {
+        SH1106_SetDrawTarget(grey_planes[plane]);
+        SH1106_DrawPixel(x, y, SH1106_GREY_COLOR(level, plane));
+    }
+    SH1106_SetDrawTarget(NULL);
+
+    SH1106_Grey_MarkDirty(x, y, x, y);
+}
+
+void SH1106_Grey_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t level)
+{
+    uint8_t plane;
+
+    if (grey_planes[0] == NULL)
+    {
+        return;
+    }
+
+    for (plane = 0; plane < 2; plane++)
+    {
+        SH1106_SetDrawTarget(grey_planes[plane]);
+        SH1106_DrawLine(x0, y0, x1, y1, SH1106_GREY_COLOR(level, plane));
+    }
+    SH1106_SetDrawTarget(NULL);
+
+    SH1106_Grey_MarkDirty(((x0 < x1) ? x0 : x1), ((y0 < y1) ? y0 : y1),
+                          ((x0 > x1) ? x0 : x1), ((y0 > y1) ? y0 : y1));
+}
+
+void SH1106_Grey_DrawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t level, bool fill)
+{
+    uint8_t plane;
+
+    if (grey_planes[0] == NULL)
+    {
+        return;
+    }
+
+    for (plane = 0; plane < 2; plane++)
+    {
+        SH1106_SetDrawTarget(grey_planes[plane]);
+        SH1106_DrawRect(x, y, w, h, SH1106_GREY_COLOR(level, plane), fill);
+    }
+    SH1106_SetDrawTarget(NULL);
+
+    // An outline also covers its right and bottom edge lines.
+    SH1106_Grey_MarkDirty(x, y, ((int16_t)x + w), ((int16_t)y + h));
+}
+
+void SH1106_Grey_DrawCircle(uint8_t x, uint8_t y, uint8_t r, uint8_t level, bool fill)
+{
+    uint8_t plane;
+
+    if (grey_planes[0] == NULL)
+    {
+        return;
+    }
+
+    for (plane = 0; plane < 2; plane++)
+    {
+        SH1106_SetDrawTarget(grey_planes[plane]);
+        SH1106_DrawCircle(x, y, r, SH1106_GREY_COLOR(level, plane), fill);
+    }
+    SH1106_SetDrawTarget(NULL);
+
+    SH1106_Grey_MarkDirty(((int16_t)x - r), ((int16_t)y - r), ((int16_t)x + r), ((int16_t)y + r));
+}
+
+// Show the plane for this tick of the grey cycle.  Call at a fixed rate; at
+// SH1106_GREY_CYCLE_TICKS ticks per cycle, 150 ticks a second gives a 50 Hz
+// cycle.  Each page sends the columns drawn since the last tick and, when the
+// plane changes, the columns where the planes differ, in one transaction.  If a
+// page fails to send the whole image is sent again on the next tick.
+int SH1106_Grey_Tick(void)
+{
+    static const uint8_t schedule[SH1106_GREY_CYCLE_TICKS] = { 1, 1, 0 };
+    uint8_t plane, page, lo, hi;
+    int retval = I2C_OK;
+
+    if (grey_planes[0] == NULL)
+    {
+        return I2C_OK;
+    }
+
+    if (grey_drawn)
+    {
+        grey_drawn = false;
+        SH1106_Grey_Diff();
+    }
+
+    plane = schedule[grey_tick];
+    grey_tick = (grey_tick + 1) % SH1106_GREY_CYCLE_TICKS;
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        lo = grey_dirty_lo[page];
+        hi = grey_dirty_hi[page];
+
+        if ((plane != grey_shown) && (grey_diff_lo[page] <= grey_diff_hi[page]))
+        {
+            if (lo > hi)
+            {
+                lo = grey_diff_lo[page];
+                hi = grey_diff_hi[page];
+            }
+            else
+            {
+                if (grey_diff_lo[page] < lo) { lo = grey_diff_lo[page]; }
+                if (grey_diff_hi[page] > hi) { hi = grey_diff_hi[page]; }
+            }
+        }
+
+        if (lo > hi)
+        {
+            continue;
+        }
+
+        retval = SH1106_DisplayImage(grey_planes[plane], lo, (page * NUM_LINES_IN_A_PAGE), ((hi - lo) + 1), NUM_LINES_IN_A_PAGE);
+        if (retval != I2C_OK)
+        {
+            grey_shown = SH1106_GREY_NO_PLANE;
+            SH1106_Grey_MarkDirty(0, 0, (SH1106_DISPLAYABLE_WIDTH_PIXELS - 1), (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1));
+            return retval;
+        }
+
+        grey_dirty_lo[page] = 0xFF;
+        grey_dirty_hi[page] = 0;
+    }
+
+    grey_shown = plane;
+
+    return retval;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// 2-bit greyscale for the SH1106 panel by cycling two bitplanes.
+// 2024-02-03 Jeff Glaum
+
+#include <xc.h> // include processor files - each processor file is guarded.
+
+#include <stdbool.h>
+
+// Grey levels.  Level bit 0 is drawn into plane 0 and bit 1 into plane 1.
+#define SH1106_GREY_BLACK       0
+#define SH1106_GREY_DARK        1
+#define SH1106_GREY_LIGHT       2
+#define SH1106_GREY_WHITE       3
+
+// Ticks in one grey cycle: plane 1 is shown for two ticks and plane 0 for one,
+// so a pixel is lit for level / 3 of the cycle.
+#define SH1106_GREY_CYCLE_TICKS 3
+
+void SH1106_Grey_Init(uint8_t *plane0, uint8_t *plane1);
+void SH1106_Grey_Stop(void);
+void SH1106_Grey_Clear(void);
+void SH1106_Grey_DrawPixel(int16_t x, int16_t y, uint8_t level);
+void SH1106_Grey_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t level);
+void SH1106_Grey_DrawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t level, bool fill);
+void SH1106_Grey_DrawCircle(uint8_t x, uint8_t y, uint8_t r, uint8_t level, bool fill);
+int  SH1106_Grey_Tick(void);
@@ -0,0 +1,184 @@
+/*
+ * File:   sh1106_mirror.c
+ * Author: jeffglaum
+ *
+ * Created on February 10, 2024, 4:15 PM
+ */
+
+// Mirrors the selected panel's image to a host over UART1.  SH1106_Mirror_Service(),
+// called from the main loop, looks at one page of the front buffer per call and
+// sends it, run-length encoded, if its CRC shows it changed since it was last
+// sent; after each pass that sent something a frame packet tells the host to
+// show the result.  Pages are only encoded when the transmit queue has room for
+// the largest packet, so the mirror never waits on the UART and never touches
+// the I2C flush; at low baud rates it simply lags and skips intermediate frames.
+//
+// Keeping a CRC per page rather than a copy of what was sent costs 16 bytes of
+// state.  Without a frame buffer there's nothing to mirror.
+
+#include "xc.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "uart.h"
+#include "sh1106_panel.h"
+#include "sh1106_mirror.h"
+
+static bool mirror_running = false;
+
+// Next page to look at (SH1106_NUM_PAGES: end of the pass).
+static uint8_t mirror_page = 0;
+
+// CRC of each page as last sent, for the pages the host has (bit 0 is page 0).
+static uint16_t mirror_crc[SH1106_NUM_PAGES];
+static uint8_t mirror_sent = 0;
+
+// Pages have been sent since the last frame packet.
+static bool mirror_changed = false;
+static uint8_t mirror_frame = 0;
+
+static uint8_t mirror_packet[SH1106_MIRROR_MAX_PACKET];
+
+
+// Encode count bytes of data into dst.  Returns the encoded length, at most
+// count + 1 for count up to SH1106_MIRROR_MAX_LITERAL (a repeat only breaks up a
+// literal when it saves at least the control byte it costs).
+static uint8_t SH1106_Mirror_Pack(const uint8_t *data, uint8_t count, uint8_t *dst)
+{
+    uint8_t i = 0, lit = 0, n = 0, run;
+
+    while (i < count)
+    {
+        run = 1;
+        while (((i + run) < count) && (data[i + run] == data[i]) && (run < SH1106_MIRROR_MAX_REPEAT))
+        {
+            run++;
+        }
+
+        if (run < SH1106_MIRROR_MIN_REPEAT)
+        {
+            i += run;
+            continue;
+        }
+
+        // Literal bytes up to the repeat, then the repeat.
+        if (lit < i)
+        {
+            dst[n++] = (i - lit) - 1;
+            while (lit < i)
+            {
+                dst[n++] = data[lit++];
+            }
+        }
+
+        dst[n++] = run + (0x80 - SH1106_MIRROR_MIN_REPEAT);
+        dst[n++] = data[i];
+        i  += run;
+        lit = i;
+    }
+
+    if (lit < count)
+    {
+        dst[n++] = (count - lit) - 1;
+        while (lit < count)
+        {
+            dst[n++] = data[lit++];
+        }
+    }
+
+    return n;
+}
+
+// Frame and queue a packet whose payload (length bytes) is already in place.
+static void SH1106_Mirror_Send(uint8_t type, uint8_t page, uint8_t length)
+{
+    uint8_t check, i;
+
+    mirror_packet[0] = SH1106_MIRROR_SYNC0;
+    mirror_packet[1] = SH1106_MIRROR_SYNC1;
+    mirror_packet[2] = type;
+    mirror_packet[3] = page;
+    mirror_packet[4] = length;
+
+    check = 0;
+    for (i = 2; i < (5 + length); i++)
+    {
+        check += mirror_packet[i];
+    }
+    mirror_packet[5 + length] = -check;
+
+    UART1_Write(mirror_packet, (SH1106_MIRROR_OVERHEAD + length));
+}
+
+// Start mirroring; the whole image is sent first.  UART1 must be initialized.
+void SH1106_Mirror_Start(void)
+{
+    mirror_running = true;
+    mirror_page    = 0;
+    mirror_changed = false;
+
+    SH1106_Mirror_Refresh();
+}
+
+void SH1106_Mirror_Stop(void)
+{
+    mirror_running = false;
+}
+
+// Send every page again on the next pass (ex: the host has just connected).
+void SH1106_Mirror_Refresh(void)
+{
+    mirror_sent = 0;
+}
+
+// Send the next page if it changed and the UART can take it.  Call once per pass
+// of the main loop; costs at most one page CRC and encode.
+void SH1106_Mirror_Service(void)
+{
+    const uint8_t *image = SH1106_GetFrontBuffer();
+    const uint8_t *data;
+    uint16_t crc;
+
+    if (!mirror_running || (image == NULL))
+    {
+        return;
+    }
+
+    if (mirror_page >= SH1106_NUM_PAGES)
+    {
+        if (mirror_changed)
+        {
+            if (UART1_TxFree() < SH1106_MIRROR_OVERHEAD)
+            {
+                return;
+            }
+
+            SH1106_Mirror_Send(SH1106_MIRROR_FRAME, mirror_frame++, 0);
+            mirror_changed = false;
+        }
+
+        mirror_page = 0;
+        return;
+    }
+
+    if (UART1_TxFree() < SH1106_MIRROR_MAX_PACKET)
+    {
+        return;
+    }
+
+    data = &image[(uint16_t)mirror_page * SH1106_PAGE_WIDTH_BYTES];
+    crc  = SH1106_PageCrc(data);
+
+    if (!(mirror_sent & (1 << mirror_page)) || (crc != mirror_crc[mirror_page]))
+    {
+        SH1106_Mirror_Send(SH1106_MIRROR_PAGE, mirror_page,
+                           SH1106_Mirror_Pack(data, SH1106_PAGE_WIDTH_BYTES, &mirror_packet[5]));
+
+        mirror_crc[mirror_page] = crc;
+        mirror_sent   |= (1 << mirror_page);
+        mirror_changed = true;
+    }
+
+    mirror_page++;
+}
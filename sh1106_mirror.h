@@ -0,0 +1,39 @@
+#pragma once
+
+// Streams the SH1106 frame buffer out UART1 so a host can mirror the panel
+// (see tools/sh1106_mirror.py).
+// 2024-02-10 Jeff Glaum
+
+#include <xc.h> // include processor files - each processor file is guarded.
+
+#include <stdbool.h>
+
+#include "sh1106_panel.h"
+
+// Packet framing: SYNC0 SYNC1 type page length payload[length] check, where check
+// makes the bytes from type to check sum to zero (mod 256).
+#define SH1106_MIRROR_SYNC0         0xA5
+#define SH1106_MIRROR_SYNC1         0x5A
+
+// Packet types.  A page packet carries one page (128 bytes, one per column)
+// run-length encoded; a frame packet (no payload, page is a frame count) follows
+// the pages changed in a pass over the image.
+#define SH1106_MIRROR_PAGE          'P'
+#define SH1106_MIRROR_FRAME         'F'
+
+// Payload encoding, a control byte followed by:
+//   0-127    control + 1 literal bytes
+//   128-255  one byte repeated control - 125 times (3 to 130)
+#define SH1106_MIRROR_MAX_LITERAL   128
+#define SH1106_MIRROR_MIN_REPEAT    3
+#define SH1106_MIRROR_MAX_REPEAT    130
+
+// Bytes of framing around the payload, and the largest packet (a page that
+// doesn't compress at all).
+#define SH1106_MIRROR_OVERHEAD      6
+#define SH1106_MIRROR_MAX_PACKET    (SH1106_MIRROR_OVERHEAD + SH1106_PAGE_WIDTH_BYTES + 1)
+
+void SH1106_Mirror_Start(void);
+void SH1106_Mirror_Stop(void);
+void SH1106_Mirror_Refresh(void);
+void SH1106_Mirror_Service(void);
@@ -11,101 +11,1822 @@
 #include "xc.h"
 
 #include <stdbool.h>       /* Includes true/false definition                  */
+#include <stdint.h>
 #include <string.h>
-#include <math.h>
 #include <stdlib.h>
 
 #include "i2c.h"
 #include "sh1106_panel.h"
+#include "sh1106_displaylist.h"
 
-// Display frame buffer.
-extern uint8_t buffer[SH1106_BUFFER_LINE_WIDTH_BYTES * SH1106_BUFFER_NUM_LINES];
+#if SH1106_USE_FRAMEBUFFER
+// Display frame buffer (the default panel's).
+extern uint8_t buffer[SH1106_BUFFER_SIZE_BYTES];
+#define SH1106_DEFAULT_FRAMEBUFFER  buffer
+#else
+// Without a frame buffer drawing goes straight to the panel's display RAM, except
+// inside SH1106_RenderStrips() where it targets the strip.
+#define SH1106_DEFAULT_FRAMEBUFFER  NULL
+
+// Write-combining cache of one block of the selected panel's display RAM columns
+// for drawing without a frame buffer.  A block is read from the panel when drawing
+// first touches it and written back when drawing moves to another block, the
+// display is flushed or another panel is selected.  The first byte receives the
+// panel's dummy read.
+#define SH1106_RMW_BLOCK_WIDTH      16
+static uint8_t rmw_block[1 + SH1106_RMW_BLOCK_WIDTH];
+static uint8_t rmw_page = SH1106_NUM_PAGES;     // No block cached.
+static uint8_t rmw_x;
+static bool rmw_dirty = false;
+#endif
+
+// Panel drawn to until another is selected, at I2C_OLED_ADDRESS.  Added by
+// SH1106_InitDisplay() or SH1106_WarmStart() when first used.
+static SH1106_Panel default_panel __attribute__((persistent));
+
+// Selected panel, and the panels added so far (flushed in turn by
+// SH1106_DisplayAll()).
+static SH1106_Panel *panel = &default_panel;
+static SH1106_Panel *panel_list = NULL;
+static uint8_t panel_count = 0;
+
+// Lines that drawing may touch (top inclusive, bottom exclusive).
+static uint8_t clip_top    = 0;
+static uint8_t clip_bottom = SH1106_DISPLAYABLE_HEIGHT_PIXELS;
+
+// Back buffer and dirty ranges put aside while SH1106_SetDrawTarget() has drawing
+// going elsewhere.
+static bool draw_target_set = false;
+static uint8_t *draw_saved_buffer;
+static uint8_t draw_saved_lo[SH1106_NUM_PAGES];
+static uint8_t draw_saved_hi[SH1106_NUM_PAGES];
+
+// Page held at the start of the back buffer (non-zero while rendering strips).
+static uint8_t base_page = 0;
+
+// Address of column x of a page in the back buffer.
+#define SH1106_DRAW_PTR(x, page)    (&panel->back_buffer[((uint16_t)((page) - base_page) * SH1106_PAGE_WIDTH_BYTES) + (x)])
+
+// Address of column x of a page to draw into, valid for *count columns (reduced to
+// fit when drawing into the display RAM cache; count may be NULL for one column).
+#if SH1106_USE_FRAMEBUFFER
+#define SH1106_DRAW_SPAN(x, page, count)    SH1106_DRAW_PTR(x, page)
+#else
+#define SH1106_DRAW_SPAN(x, page, count)    ((panel->back_buffer != NULL) ? SH1106_DRAW_PTR(x, page) : SH1106_RmwSpan((x), (page), (count)))
+#endif
+
+// The flush in progress.  Each panel's latched column ranges (flush_lo/hi) are
+// owned by the flush interrupt chain while flush_busy is set; ranges that fail to
+// send stay latched and are merged into the next flush.  The bus is shared so
+// there's one flush at a time, taking the flushing panels in turn a page at a
+// time (flush_panel is the one whose run is on the bus).
+static volatile bool flush_busy = false;
+static volatile uint8_t flush_runs_done = 0;
+static SH1106_Panel *flush_panel = NULL;
+static uint8_t flush_run_lo;
+static uint8_t flush_run_hi;
+static uint8_t flush_hdr[7];
+static SH1106_FlushCallback flush_callback = NULL;
+
+// Last failed flush transfer, until read by SH1106_GetFlushError().
+static SH1106_FlushError flush_error = { I2C_OK };
+
+// Times a panel's failed runs are resent in one flush (after recovering the bus)
+// before it's left out of the rest of the flush.
+#define SH1106_FLUSH_RETRIES    2
+
+// Unchanged columns worth resending rather than starting a new transaction for the
+// next run (START, address, page/column header and STOP cost about this much).
+#define SH1106_RUN_MERGE_GAP    9
+
+#define SH1106_PAGE_OFFSET(page)    ((uint16_t)(page) * SH1106_PAGE_WIDTH_BYTES)
+
+// Panel settings, in the order they're sent at initialization.  Two byte commands
+// keep their argument, the rest keep the command byte itself.
+#define SH1106_CFG_CLOCKDIV     0
+#define SH1106_CFG_MULTIPLEX    1
+#define SH1106_CFG_OFFSET       2
+#define SH1106_CFG_STARTLINE    3
+#define SH1106_CFG_SEGREMAP     4
+#define SH1106_CFG_COMSCAN      5
+#define SH1106_CFG_COMPINS      6
+#define SH1106_CFG_CONTRAST     7
+#define SH1106_CFG_PRECHARGE    8
+#define SH1106_CFG_VCOMDETECT   9
+#define SH1106_CFG_ALLON        10
+#define SH1106_CFG_INVERT       11
+#define SH1106_CFG_DISPLAYON    12
+#define SH1106_CFG_COUNT        SH1106_CONFIG_COUNT
+
+// Leading command byte of each two byte setting (0 for single byte settings).
+static const uint8_t config_command[SH1106_CFG_COUNT] = {
+    SH1106_SETDISPLAYCLOCKDIV, SH1106_SETMULTIPLEX, SH1106_SETDISPLAYOFFSET, 0, 0, 0,
+    SH1106_SETCOMPINS, SH1106_SETCONTRAST, SH1106_SETPRECHARGE, SH1106_SETVCOMDETECT, 0, 0, 0
+};
+
+// Settings for the SH1106 132x64 OLED module.
+static const uint8_t config_default[SH1106_CFG_COUNT] = {
+    0x50,                           // Clock divider.  PoR value is 0x50.
+    0x3F,                           // Multiplex mode ratio.  PoR value is 0x3F (63).
+    0x00,                           // Mapping display start line.  PoR value ix 0x0.
+    SH1106_SETSTARTLINE | 0x0,      // COM0 display line 0.
+    SH1106_SEGREMAP | 0x1,          // Segment re-map to left rotation.
+    SH1106_COMSCANDEC,
+    0x12,                           // COM pins.
+    0x80,                           // Contrast.
+    0x22,                           // Pre-charge period.
+    0x40,                           // VCOM deselect level.
+    SH1106_DISPLAYALLON_RESUME,
+    SH1106_NORMALDISPLAY,
+    SH1106_DISPLAYON
+};
+
+// Each panel keeps a mirror of the settings it holds (SH1106_Panel.config).  When
+// the panel is in persistent RAM (not cleared by a reset) the check word tells
+// SH1106_WarmStart() whether the mirror survived, so after a reset that didn't
+// power the panel down it knows how the panel is set up.  config_known is set
+// while the mirror can be trusted to skip sending settings.
+#define SH1106_CONFIG_MAGIC     0x5A11
+
+// Command sequence queued by SH1106_QueueCommand(), preceded by its control byte.
+#define SH1106_COMMAND_QUEUE_SIZE   24
+static uint8_t cmd_queue[1 + SH1106_COMMAND_QUEUE_SIZE] = { SH1106_CONTROL_COMMAND_STREAM };
+static uint8_t cmd_count = 0;
 
     
-static void SH1106_command(uint8_t c)
-{    
-    I2C1_M_Write(I2C_OLED_ADDRESS, 0, 1, &c);
+// Polls of SH1106_WaitFlush() without a run completing before an asynchronous
+// flush is taken to have stalled (roughly 100 ms at 4 MIPS, several times the
+// longest run).
+#define SH1106_FLUSH_TIMEOUT    40000UL
+
+static void SH1106_FlushStalled(void);
+
+// Wait for an asynchronous flush to finish before using the bus.  If the bus
+// stops making progress the flush is cancelled, leaving what wasn't sent latched
+// for the next flush.
+static void SH1106_WaitFlush(void)
+{
+    uint8_t runs_done = flush_runs_done;
+    uint32_t i = 0;
+
+    while (flush_busy)
+    {
+        if (flush_runs_done != runs_done)
+        {
+            runs_done = flush_runs_done;
+            i = 0;
+        }
+        else if (i++ > SH1106_FLUSH_TIMEOUT)
+        {
+            SH1106_FlushStalled();
+            break;
+        }
+    }
 }
 
-void SH1106_Display(void) {
-	
-    SH1106_command(SH1106_SETLOWCOLUMN  | 0x0);     // Set low column = 0.
-    SH1106_command(SH1106_SETHIGHCOLUMN | 0x0);     // Set high column = 0.
-    SH1106_command(SH1106_SETSTARTLINE  | 0x0);     // Set start line = 0.
-	
-    uint8_t page, line = 0;
-    uint32_t offset = 0;
-    uint8_t width_bytes = (SH1106_REAL_OLED_WIDTH_PIXELS / 8);
+// Single transaction bus write to a panel, accounting for it in the panel's frame
+// statistics.
+static int SH1106_Write(SH1106_Panel *p, uint8_t hdr_count, uint8_t *hdr, uint16_t data_count, uint8_t *data)
+{
+    SH1106_WaitFlush();
+
+    p->frame_stats.transactions++;
+    p->frame_stats.overheadBytes += (1 + hdr_count);    // Address byte plus header.
+    p->frame_stats.dataBytes     += data_count;
+
+    return I2C1_M_WriteEx(p->address, hdr_count, hdr, data_count, data);
+}
+
+// Start a new command sequence, discarding anything queued but not yet sent.
+void SH1106_BeginCommands(void)
+{
+    cmd_count = 0;
+}
+
+// Send the queued command sequence in a single transaction.  A 0x00 control byte
+// leads the sequence so every byte that follows is taken as a command byte.
+int SH1106_SendCommands(void)
+{
+    int retval = I2C_OK;
+
+    if (cmd_count > 0)
+    {
+        retval = SH1106_Write(panel, (1 + cmd_count), cmd_queue, 0, NULL);
+        cmd_count = 0;
+    }
+
+    return retval;
+}
+
+// Append a command byte to the sequence, sending the sequence early if it's full.
+void SH1106_QueueCommand(uint8_t c)
+{
+    if (cmd_count >= SH1106_COMMAND_QUEUE_SIZE)
+    {
+        SH1106_SendCommands();
+    }
+
+    cmd_queue[1 + cmd_count++] = c;
+}
+
+// Append a two byte command (ex: SH1106_SETCONTRAST + value).  Both bytes are kept
+// in the same transaction.
+void SH1106_QueueCommandArg(uint8_t c, uint8_t arg)
+{
+    if (cmd_count >= (SH1106_COMMAND_QUEUE_SIZE - 1))
+    {
+        SH1106_SendCommands();
+    }
+
+    cmd_queue[1 + cmd_count++] = c;
+    cmd_queue[1 + cmd_count++] = arg;
+}
+
+// Check word over the selected panel's settings mirror.
+static uint16_t SH1106_ConfigCheck(void)
+{
+    uint16_t check = SH1106_CONFIG_MAGIC;
+    uint8_t i;
+
+    for (i = 0; i < SH1106_CFG_COUNT; i++)
+    {
+        check = (check << 1) ^ (check >> 15) ^ panel->config[i];
+    }
+
+    return check;
+}
+
+// Queue a setting unless the panel is known to have it already.
+static void SH1106_QueueSetting(uint8_t setting, uint8_t value)
+{
+    if (panel->config_known && (panel->config[setting] == value))
+    {
+        return;
+    }
+
+    if (config_command[setting] != 0)
+    {
+        SH1106_QueueCommandArg(config_command[setting], value);
+    }
+    else
+    {
+        SH1106_QueueCommand(value);
+    }
+
+    panel->config[setting] = value;
+}
+
+// Send the queued settings and bring the mirror's check word up to date.  If the
+// send fails the panel's settings are no longer known.
+static int SH1106_SendSettings(void)
+{
+    int retval = SH1106_SendCommands();
+
+    if (retval != I2C_OK)
+    {
+        panel->config_known = false;
+    }
+    panel->config_check = SH1106_ConfigCheck() ^ (panel->config_known ? 0 : 0xFFFF);
+
+    return retval;
+}
+
+// Build the header that addresses display RAM column col of a page ahead of its
+// data.  The page and column address commands are carried using continuation
+// control bytes.
+static void SH1106_PageHeader(uint8_t *hdr, uint8_t page, uint8_t col)
+{
+    hdr[0] = SH1106_CONTROL_COMMAND;
+    hdr[1] = SH1106_SET_PAGEADDRESS | page;                 // Set page address.
+    hdr[2] = SH1106_CONTROL_COMMAND;
+    hdr[3] = SH1106_SETLOWCOLUMN  | (col & 0x0F);           // Set low column nibble.
+    hdr[4] = SH1106_CONTROL_COMMAND;
+    hdr[5] = SH1106_SETHIGHCOLUMN | (col >> 4);             // Set high column nibble.
+    hdr[6] = SH1106_CONTROL_DATA_STREAM;                    // Page data follows.
+}
+
+// Send count bytes of page data starting at column x in a single transaction.
+static int SH1106_WritePage(SH1106_Panel *p, uint8_t page, uint8_t x, uint16_t count, uint8_t *data)
+{
+    uint8_t hdr[sizeof(flush_hdr)];
+
+    SH1106_PageHeader(hdr, page, (p->column_offset + x));
+
+    return SH1106_Write(p, sizeof(hdr), hdr, count, data);
+}
+
+#if !SH1106_USE_FRAMEBUFFER
+// Read count bytes of the selected panel's display RAM starting at column x of a
+// page in a single transaction.  The panel returns a dummy byte first so data must have room for
+// count + 1 bytes.
+static int SH1106_ReadPage(uint8_t page, uint8_t x, uint16_t count, uint8_t *data)
+{
+    uint8_t hdr[sizeof(flush_hdr)];
+
+    SH1106_WaitFlush();
+    SH1106_PageHeader(hdr, page, (panel->column_offset + x));
+
+    panel->frame_stats.transactions++;
+    panel->frame_stats.overheadBytes += (1 + sizeof(hdr) + 1 + 1);  // Address, header, read address and dummy byte.
+    panel->frame_stats.dataBytes     += count;
+
+    return I2C1_M_ReadEx(panel->address, sizeof(hdr), hdr, (count + 1), data);
+}
+
+// Write the cached display RAM block back to the panel if it was drawn into.
+static void SH1106_RmwWriteBack(void)
+{
+    if (rmw_dirty)
+    {
+        rmw_dirty = false;
+        SH1106_WritePage(panel, rmw_page, rmw_x, SH1106_RMW_BLOCK_WIDTH, &rmw_block[1]);
+    }
+}
+
+// Write back and forget the cached block (ex: before display RAM is overwritten or
+// another panel is selected).
+static void SH1106_RmwInvalidate(void)
+{
+    SH1106_RmwWriteBack();
+    rmw_page = SH1106_NUM_PAGES;
+}
+
+// Address of column x of a page in the display RAM cache, loading the block that
+// holds it first.  Returned columns are assumed to be modified.
+static uint8_t *SH1106_RmwSpan(uint8_t x, uint8_t page, uint8_t *count)
+{
+    uint8_t avail;
+
+    if ((page != rmw_page) || (x < rmw_x) || (x >= (rmw_x + SH1106_RMW_BLOCK_WIDTH)))
+    {
+        SH1106_RmwWriteBack();
+
+        rmw_page = page;
+        rmw_x    = x & ~(SH1106_RMW_BLOCK_WIDTH - 1);
+        if (SH1106_ReadPage(rmw_page, rmw_x, SH1106_RMW_BLOCK_WIDTH, rmw_block) != I2C_OK)
+        {
+            // Nothing sensible to draw over; the write back will fail too unless
+            // the bus recovers.
+            memset(rmw_block, 0, sizeof(rmw_block));
+        }
+    }
+
+    rmw_dirty = true;
+
+    avail = (rmw_x + SH1106_RMW_BLOCK_WIDTH) - x;
+    if ((count != NULL) && (*count > avail))
+    {
+        *count = avail;
+    }
+
+    return &rmw_block[1 + (x - rmw_x)];
+}
+#else
+#define SH1106_RmwWriteBack()
+#define SH1106_RmwInvalidate()
+#endif
+
+// Record that columns x0-x1 of the lines y0-y1 (inclusive, already clipped to
+// the display) have been modified.
+static void SH1106_MarkDirty(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1)
+{
+    uint8_t page;
+
+    for (page = (y0 / NUM_LINES_IN_A_PAGE); page <= (y1 / NUM_LINES_IN_A_PAGE); page++)
+    {
+        if (x0 < panel->dirty_lo[page]) { panel->dirty_lo[page] = x0; }
+        if (x1 > panel->dirty_hi[page]) { panel->dirty_hi[page] = x1; }
+    }
+}
+
+static void SH1106_MarkClean(uint8_t page)
+{
+    panel->dirty_lo[page] = 0xFF;
+    panel->dirty_hi[page] = 0;
+}
+
+// Move the dirty ranges into the flush ranges, merging with anything a previous
+// flush failed to send.
+static void SH1106_LatchDirty(void)
+{
+    uint8_t page;
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        if (panel->dirty_lo[page] > panel->dirty_hi[page])
+        {
+            continue;
+        }
+
+        if (panel->flush_lo[page] > panel->flush_hi[page])
+        {
+            panel->flush_lo[page] = panel->dirty_lo[page];
+            panel->flush_hi[page] = panel->dirty_hi[page];
+        }
+        else
+        {
+            if (panel->dirty_lo[page] < panel->flush_lo[page]) { panel->flush_lo[page] = panel->dirty_lo[page]; }
+            if (panel->dirty_hi[page] > panel->flush_hi[page]) { panel->flush_hi[page] = panel->dirty_hi[page]; }
+        }
+
+        SH1106_MarkClean(page);
+    }
+}
+
+// Record the value a setting should have.  Nothing is sent until the next flush
+// (or SH1106_ApplySettings()), so a setting changed several times in between only
+// goes out once, with its last value.
+static void SH1106_SetPending(uint8_t setting, uint8_t value)
+{
+    panel->pending[setting]  = value;
+    panel->pending_mask     |= (1 << setting);
+}
+
+// Clear the display RAM either side of the image on the pages where
+// SH1106_SetPixelShift() failed to.
+static void SH1106_ClearEdges(void)
+{
+    uint8_t zeros[2 * SH1106_MAX_SHIFT_X] = { 0 };
+    uint8_t hdr[sizeof(flush_hdr)];
+    uint8_t right = panel->column_offset + SH1106_PAGE_WIDTH_BYTES;
+    uint8_t page;
+    int status;
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        if (!(panel->edge_clear & (1 << page)))
+        {
+            continue;
+        }
+
+        status = I2C_OK;
+        if (panel->column_offset > 0)
+        {
+            SH1106_PageHeader(hdr, page, 0);
+            status = SH1106_Write(panel, sizeof(hdr), hdr, panel->column_offset, zeros);
+        }
+        if ((status == I2C_OK) && (right < SH1106_REAL_OLED_WIDTH_PIXELS))
+        {
+            SH1106_PageHeader(hdr, page, right);
+            status = SH1106_Write(panel, sizeof(hdr), hdr, (SH1106_REAL_OLED_WIDTH_PIXELS - right), zeros);
+        }
+
+        if (status == I2C_OK)
+        {
+            panel->edge_clear &= ~(1 << page);
+        }
+    }
+}
+
+// Send the selected panel's pending settings in a single transaction, leaving out
+// any the panel already has (ex: inverted and back again since the last flush).
+// Called by SH1106_Flip() so they go out just ahead of the frame, along with any
+// edge columns a pixel shift failed to clear.
+int SH1106_ApplySettings(void)
+{
+    uint8_t i;
+
+    if (panel->edge_clear != 0)
+    {
+        SH1106_ClearEdges();
+    }
+
+    if (panel->pending_mask == 0)
+    {
+        return I2C_OK;
+    }
+
+    SH1106_BeginCommands();
+    for (i = 0; i < SH1106_CFG_COUNT; i++)
+    {
+        if (panel->pending_mask & (1 << i))
+        {
+            SH1106_QueueSetting(i, panel->pending[i]);
+        }
+    }
+    panel->pending_mask = 0;
+
+    return SH1106_SendSettings();
+}
+
+// CRC-16/CCITT of a page, a nibble at a time.  (A Fletcher checksum is cheaper
+// but can't tell an all 0x00 page from an all 0xFF one.)
+uint16_t SH1106_PageCrc(const uint8_t *data)
+{
+    static const uint16_t crc_table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+    };
+    uint16_t crc = 0xFFFF;
+    uint8_t i;
+
+    for (i = 0; i < SH1106_PAGE_WIDTH_BYTES; i++)
+    {
+        crc = (crc << 4) ^ crc_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crc_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+
+    return crc;
+}
+
+// Drop latched pages that are identical to what the panel already holds (ex: the
+// same screen redrawn from scratch), going by their CRC.  Every
+// SH1106_PAGE_CRC_REFRESH flips the pages skipped since the last refresh are
+// latched in full and sent regardless, in case a CRC matched a changed page.
+static void SH1106_SkipUnchangedPages(void)
+{
+    uint8_t page;
+
+    if (!panel->page_crc_enabled)
+    {
+        return;
+    }
+
+    if (++panel->page_crc_flips >= SH1106_PAGE_CRC_REFRESH)
+    {
+        for (page = 0; page < SH1106_NUM_PAGES; page++)
+        {
+            if (panel->page_crc_skipped & (1 << page))
+            {
+                panel->flush_lo[page] = 0;
+                panel->flush_hi[page] = SH1106_PAGE_WIDTH_BYTES - 1;
+            }
+        }
+
+        panel->page_crc_valid  &= ~panel->page_crc_skipped;
+        panel->page_crc_skipped = 0;
+        panel->page_crc_flips   = 0;
+    }
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        if (panel->flush_lo[page] <= panel->flush_hi[page])
+        {
+            uint16_t crc = SH1106_PageCrc(&panel->front_buffer[SH1106_PAGE_OFFSET(page)]);
+
+            if ((panel->page_crc_valid & (1 << page)) && (crc == panel->page_crc[page]))
+            {
+                panel->flush_lo[page] = 0xFF;
+                panel->flush_hi[page] = 0;
+                panel->page_crc_skipped |= (1 << page);
+                panel->frame_stats.skipped++;
+            }
+            else
+            {
+                panel->page_crc[page]  = crc;
+                panel->page_crc_valid &= ~(1 << page);
+            }
+        }
+    }
+}
+
+static void SH1106_EndFrame(SH1106_Panel *p)
+{
+    p->last_frame_stats = p->frame_stats;
+    memset(&p->frame_stats, 0, sizeof(p->frame_stats));
+}
+
+// Make the drawing done so far the next thing to be sent.  Waits for any flush in
+// progress (the safe point), latches the dirty ranges and, when double buffered,
+// swaps the front and back buffers.  The latched spans are then copied into the new
+// back buffer so drawing can carry on from the image just flipped.
+//
+// Called by SH1106_Display() and SH1106_DisplayAsync(); flipping again without
+// drawing in between is harmless.
+void SH1106_Flip(void)
+{
+    uint8_t page;
+    uint8_t *swap;
+
+    SH1106_WaitFlush();
+    SH1106_RmwWriteBack();
+    SH1106_ApplySettings();
+
+    if (panel->front_buffer == NULL)
+    {
+        return;
+    }
+
+    SH1106_LatchDirty();
+
+    if (panel->back_buffer != panel->front_buffer)
+    {
+        swap                = panel->front_buffer;
+        panel->front_buffer = panel->back_buffer;
+        panel->back_buffer  = swap;
+
+        for (page = 0; page < SH1106_NUM_PAGES; page++)
+        {
+            if (panel->flush_lo[page] <= panel->flush_hi[page])
+            {
+                uint16_t offset = SH1106_PAGE_OFFSET(page) + panel->flush_lo[page];
+
+                memcpy(&panel->back_buffer[offset], &panel->front_buffer[offset], ((panel->flush_hi[page] - panel->flush_lo[page]) + 1));
+            }
+        }
+    }
+
+    SH1106_SkipUnchangedPages();
+}
+
+#if SH1106_USE_FRAMEBUFFER
+// Enable double buffering using the given buffer (SH1106_BUFFER_SIZE_BYTES long) as
+// the selected panel's second frame buffer, or disable it when back is NULL.  The
+// current image is carried over either way.
+void SH1106_SetBackBuffer(uint8_t *back)
+{
+    SH1106_WaitFlush();
+
+    if (back == NULL)
+    {
+        if (panel->back_buffer != panel->frame_buffer)
+        {
+            memcpy(panel->frame_buffer, panel->back_buffer, SH1106_BUFFER_SIZE_BYTES);
+        }
+        panel->back_buffer = panel->front_buffer = panel->frame_buffer;
+        return;
+    }
+
+    // Either copy may be of a buffer onto itself (ex: turning double buffering on
+    // while the frame buffer is still the one drawn into).
+    if (back != panel->back_buffer)
+    {
+        memcpy(back, panel->back_buffer, SH1106_BUFFER_SIZE_BYTES);
+    }
+    if (panel->frame_buffer != panel->back_buffer)
+    {
+        memcpy(panel->frame_buffer, panel->back_buffer, SH1106_BUFFER_SIZE_BYTES);
+    }
+    panel->front_buffer = panel->frame_buffer;
+    panel->back_buffer  = back;
+}
+#endif
+
+// Force the whole frame buffer to be sent on the next SH1106_Display() (ex: after
+// writing to the frame buffer directly or re-initializing the panel).
+void SH1106_InvalidateDisplay(void)
+{
+    SH1106_WaitFlush();
+
+    panel->shadow_stale   = 0xFF;
+    panel->page_crc_valid = 0;
+    SH1106_MarkDirty(0, (SH1106_DISPLAYABLE_WIDTH_PIXELS - 1), 0, (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1));
+}
+
+// Keep a copy of the panel's display RAM in the given buffer (SH1106_BUFFER_SIZE_BYTES
+// long) so flushes only send the columns that actually differ from what the panel
+// shows, or stop doing so when shadow is NULL.  The whole display is resent once
+// to bring the copy up to date.
+void SH1106_SetShadowBuffer(uint8_t *shadow)
+{
+    SH1106_WaitFlush();
+
+    panel->shadow_buffer = shadow;
+    SH1106_InvalidateDisplay();
+}
+
+// Find the next run of columns to send in a panel's latched page, starting from the page's
+// latched low column.  Without a shadow buffer this is the rest of the latched
+// range.  With one, columns that match the panel are skipped and runs separated by
+// no more than SH1106_RUN_MERGE_GAP matching columns are merged.  Marks the page
+// clean and returns false once there's nothing left to send.
+static bool SH1106_NextRun(SH1106_Panel *p, uint8_t page, uint8_t *run_lo, uint8_t *run_hi)
+{
+    uint8_t lo = p->flush_lo[page];
+    uint8_t hi = p->flush_hi[page];
+
+    if (lo > hi)
+    {
+        return false;
+    }
+
+    if ((p->shadow_buffer != NULL) && !(p->shadow_stale & (1 << page)))
+    {
+        uint8_t *front  = &p->front_buffer[SH1106_PAGE_OFFSET(page)];
+        uint8_t *shadow = &p->shadow_buffer[SH1106_PAGE_OFFSET(page)];
+        uint8_t x;
+
+        while ((lo <= hi) && (front[lo] == shadow[lo]))
+        {
+            lo++;
+        }
+
+        if (lo > hi)
+        {
+            p->flush_lo[page]  = 0xFF;
+            p->flush_hi[page]  = 0;
+            p->page_crc_valid |= (1 << page);
+            return false;
+        }
+
+        for (x = lo + 1, hi = lo; x <= p->flush_hi[page]; x++)
+        {
+            if (front[x] != shadow[x])
+            {
+                hi = x;
+            }
+            else if ((x - hi) > SH1106_RUN_MERGE_GAP)
+            {
+                break;
+            }
+        }
+    }
+
+    *run_lo = lo;
+    *run_hi = hi;
+    return true;
+}
+
+// Record that a run of columns made it to the panel.
+static void SH1106_RunSent(SH1106_Panel *p, uint8_t page, uint8_t run_lo, uint8_t run_hi)
+{
+    p->frame_stats.runs++;
+
+    if (p->shadow_buffer != NULL)
+    {
+        memcpy(&p->shadow_buffer[SH1106_PAGE_OFFSET(page) + run_lo],
+               &p->front_buffer[SH1106_PAGE_OFFSET(page) + run_lo], ((run_hi - run_lo) + 1));
+    }
+
+    if (run_hi >= p->flush_hi[page])
+    {
+        // Page finished.  The panel now holds the page the CRC was taken of, and
+        // the shadow copy is complete, unless the page was stale and only part of it
+        // was sent (ex: after SH1106_DisplayImage()).
+        if (!(p->shadow_stale & (1 << page)) ||
+            ((run_lo == 0) && (run_hi == (SH1106_PAGE_WIDTH_BYTES - 1))))
+        {
+            p->shadow_stale   &= ~(1 << page);
+            p->page_crc_valid |= (1 << page);
+        }
+        p->flush_lo[page] = 0xFF;
+        p->flush_hi[page] = 0;
+    }
+    else
+    {
+        p->flush_lo[page] = run_hi + 1;
+    }
+}
+
+// Flip the selected panel and have it take part in the next flush.  A bus left
+// dirty by a failed asynchronous flush is recovered first.
+static void SH1106_FlipForFlush(void)
+{
+    SH1106_WaitFlush();
+    I2C1_M_Recover();
+    SH1106_Flip();
+
+    panel->flushing   = true;
+    panel->flush_page = 0;
+}
+
+// Flip every panel for the next flush.
+static void SH1106_FlipAllForFlush(void)
+{
+    SH1106_Panel *selected = panel;
+
+    // The display RAM cache belongs to the selected panel.
+    SH1106_RmwWriteBack();
+
+    for (panel = panel_list; panel != NULL; panel = panel->next)
+    {
+        SH1106_FlipForFlush();
+    }
+
+    panel = selected;
+}
+
+// Find the next run to send, taking the flushing panels in turn: each panel sends
+// the runs of one page and then gives the next panel a turn, so a panel with a lot
+// to send doesn't hold the others up.  Leaves the run's panel in flush_panel (its
+// flush_page is the run's page) and returns false once every panel is done.
+static bool SH1106_NextFlush(void)
+{
+    SH1106_Panel *p = flush_panel;
+    uint8_t n;
+
+    // Finish the page in progress first.
+    if ((p != NULL) && p->flushing && (p->flush_page < SH1106_NUM_PAGES) &&
+        SH1106_NextRun(p, p->flush_page, &flush_run_lo, &flush_run_hi))
+    {
+        return true;
+    }
+
+    for (n = 0; n < panel_count; n++)
+    {
+        p = ((p == NULL) || (p->next == NULL)) ? panel_list : p->next;
+
+        if (!p->flushing)
+        {
+            continue;
+        }
+
+        for ( ; p->flush_page < SH1106_NUM_PAGES; p->flush_page++)
+        {
+            if (SH1106_NextRun(p, p->flush_page, &flush_run_lo, &flush_run_hi))
+            {
+                flush_panel = p;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Close the frame of every panel that took part in the flush.
+static void SH1106_EndFlush(void)
+{
+    SH1106_Panel *p;
+
+    for (p = panel_list; p != NULL; p = p->next)
+    {
+        if (p->flushing)
+        {
+            p->flushing = false;
+            SH1106_EndFrame(p);
+        }
+    }
+
+    flush_panel = NULL;
+}
+
+// Record where a run failed.  The run stays latched so the flush resumes from it.
+// The panel may have taken part of the run, so its copy of the page is no longer
+// known: the page's CRC is dropped and, with a shadow copy, the page is latched in
+// full and resent without comparing.
+static void SH1106_FlushFailed(SH1106_Panel *p, int status)
+{
+    uint8_t page = p->flush_page;
+
+    p->frame_stats.errors++;
+
+    flush_error.status  = status;
+    flush_error.address = p->address;
+    flush_error.page    = page;
+    flush_error.column  = flush_run_lo;
+
+    p->page_crc_valid &= ~(1 << page);
+    if (p->shadow_buffer != NULL)
+    {
+        p->shadow_stale  |= (1 << page);
+        p->flush_lo[page] = 0;
+        p->flush_hi[page] = SH1106_PAGE_WIDTH_BYTES - 1;
+    }
+}
+
+// Send only the columns that changed since the last update, one transaction per
+// run.  A failed run is resent once the bus has been recovered; a panel that keeps
+// failing is left out of the rest of the flush, and if the bus can't be recovered
+// the flush stops.  Whatever isn't sent stays latched for the next flush.
+static void SH1106_FlushRuns(void)
+{
+    while (SH1106_NextFlush())
+    {
+        SH1106_Panel *p = flush_panel;
+        int status;
+
+        status = SH1106_WritePage(p, p->flush_page, flush_run_lo, ((flush_run_hi - flush_run_lo) + 1),
+                                  &p->front_buffer[SH1106_PAGE_OFFSET(p->flush_page) + flush_run_lo]);
+        if (status != I2C_OK)
+        {
+            SH1106_FlushFailed(p, status);
+
+            if (I2C1_M_Recover() != I2C_OK)
+            {
+                break;
+            }
+
+            if (p->frame_stats.retries >= SH1106_FLUSH_RETRIES)
+            {
+                p->flushing = false;
+                SH1106_EndFrame(p);
+            }
+            else
+            {
+                p->frame_stats.retries++;
+            }
+            continue;
+        }
+
+        SH1106_RunSent(p, p->flush_page, flush_run_lo, flush_run_hi);
+    }
+
+    SH1106_EndFlush();
+}
+
+void SH1106_Display(void) {
+
+    SH1106_FlipForFlush();
+    SH1106_FlushRuns();
+}
+
+// Flush every panel added with SH1106_AddPanel(), interleaving their pages.
+void SH1106_DisplayAll(void)
+{
+    SH1106_FlipAllForFlush();
+    SH1106_FlushRuns();
+}
+
+// Send just the given rectangle of the frame buffer (the pages it covers, limited
+// to its columns) straight away, for callers that know exactly what they redrew.
+// With a single buffer, the sent columns no longer count as dirty.
+int SH1106_DisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    uint8_t page, first_page, last_page, x0, x1;
+    int retval = I2C_OK;
+
+    if (panel->back_buffer == NULL)
+    {
+        return I2C_OK;
+    }
+
+    // Clip to the display.
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if ((x + w) > SH1106_DISPLAYABLE_WIDTH_PIXELS)  { w = SH1106_DISPLAYABLE_WIDTH_PIXELS - x; }
+    if ((y + h) > SH1106_DISPLAYABLE_HEIGHT_PIXELS) { h = SH1106_DISPLAYABLE_HEIGHT_PIXELS - y; }
+    if ((w <= 0) || (h <= 0)) { return I2C_OK; }
+
+    x0 = x;
+    x1 = x + w - 1;
+    first_page = y / NUM_LINES_IN_A_PAGE;
+    last_page  = (y + h - 1) / NUM_LINES_IN_A_PAGE;
+
+    for (page = first_page; page <= last_page; page++)
+    {
+        retval = SH1106_WritePage(panel, page, x0, ((x1 - x0) + 1), &panel->back_buffer[SH1106_PAGE_OFFSET(page) + x0]);
+        if (retval != I2C_OK)
+        {
+            // The panel may have taken part of the write, so with a shadow copy the
+            // whole page goes with the next flush, uncompared.
+            panel->shadow_stale   |= (1 << page);
+            panel->page_crc_valid &= ~(1 << page);
+            if (panel->shadow_buffer != NULL)
+            {
+                SH1106_MarkDirty(0, (SH1106_PAGE_WIDTH_BYTES - 1), (page * NUM_LINES_IN_A_PAGE), (page * NUM_LINES_IN_A_PAGE));
+            }
+            break;
+        }
+
+        if ((panel->shadow_buffer != NULL) && !(panel->shadow_stale & (1 << page)))
+        {
+            memcpy(&panel->shadow_buffer[SH1106_PAGE_OFFSET(page) + x0], &panel->back_buffer[SH1106_PAGE_OFFSET(page) + x0], ((x1 - x0) + 1));
+        }
+        panel->page_crc_valid &= ~(1 << page);
+
+        // Trim the dirty range.  Double buffering still needs it to keep the
+        // buffers in step at the next flip.
+        if ((panel->back_buffer == panel->front_buffer) && (panel->dirty_lo[page] <= panel->dirty_hi[page]))
+        {
+            if ((panel->dirty_lo[page] >= x0) && (panel->dirty_hi[page] <= x1))
+            {
+                SH1106_MarkClean(page);
+            }
+            else if ((panel->dirty_lo[page] >= x0) && (panel->dirty_lo[page] <= x1))
+            {
+                panel->dirty_lo[page] = x1 + 1;
+            }
+            else if ((panel->dirty_hi[page] >= x0) && (panel->dirty_hi[page] <= x1))
+            {
+                panel->dirty_hi[page] = x0 - 1;
+            }
+        }
+    }
+
+    return retval;
+}
+
+// Send a rectangle of an image laid out like the frame buffer (the pages it
+// covers, limited to its columns) straight to the panel, one transaction per page.
+// The frame buffer and its dirty state are left alone; the shadow copy and page
+// checksums of the pages sent no longer match the panel so they're dropped.
+int SH1106_DisplayImage(const uint8_t *image, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    uint8_t page, first_page, last_page;
+    int retval = I2C_OK;
+
+    // Clip to the display.
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if ((x + w) > SH1106_DISPLAYABLE_WIDTH_PIXELS)  { w = SH1106_DISPLAYABLE_WIDTH_PIXELS - x; }
+    if ((y + h) > SH1106_DISPLAYABLE_HEIGHT_PIXELS) { h = SH1106_DISPLAYABLE_HEIGHT_PIXELS - y; }
+    if ((w <= 0) || (h <= 0)) { return I2C_OK; }
+
+    first_page = y / NUM_LINES_IN_A_PAGE;
+    last_page  = (y + h - 1) / NUM_LINES_IN_A_PAGE;
+
+    SH1106_WaitFlush();
+    SH1106_RmwInvalidate();
+
+    for (page = first_page; page <= last_page; page++)
+    {
+        // Even a failed write may have reached the panel part way.
+        panel->shadow_stale   |= (1 << page);
+        panel->page_crc_valid &= ~(1 << page);
+
+        retval = SH1106_WritePage(panel, page, x, w, (uint8_t *)&image[SH1106_PAGE_OFFSET(page) + x]);
+        if (retval != I2C_OK)
+        {
+            break;
+        }
+    }
+
+    return retval;
+}
+
+// Draw into target (SH1106_BUFFER_SIZE_BYTES long, laid out like the frame buffer)
+// instead of the selected panel's back buffer, or go back to the back buffer when
+// target is NULL.  Drawing done into a target isn't marked dirty.
+void SH1106_SetDrawTarget(uint8_t *target)
+{
+    if (!draw_target_set)
+    {
+        if (target == NULL)
+        {
+            return;
+        }
+
+        SH1106_RmwWriteBack();
+
+        draw_target_set   = true;
+        draw_saved_buffer = panel->back_buffer;
+        memcpy(draw_saved_lo, panel->dirty_lo, sizeof(draw_saved_lo));
+        memcpy(draw_saved_hi, panel->dirty_hi, sizeof(draw_saved_hi));
+    }
+    else if (target == NULL)
+    {
+        draw_target_set    = false;
+        panel->back_buffer = draw_saved_buffer;
+        memcpy(panel->dirty_lo, draw_saved_lo, sizeof(draw_saved_lo));
+        memcpy(panel->dirty_hi, draw_saved_hi, sizeof(draw_saved_hi));
+        return;
+    }
+
+    panel->back_buffer = target;
+}
+
+// Render the display one page at a time through a single page sized buffer
+// (SH1106_PAGE_WIDTH_BYTES long) instead of a frame buffer.  For each page the
+// strip is cleared, clipping is set to the page's 8 lines and draw is called to
+// draw the whole scene (anything outside the strip is discarded), then the strip
+// is sent before moving on to the next page.
+//
+// The frame buffer (if any) and its dirty state are left untouched; the shadow
+// copy no longer matches the panel so it's marked stale.
+int SH1106_RenderStrips(uint8_t *strip, SH1106_DrawCallback draw)
+{
+    return SH1106_RenderPages(strip, draw, 0xFF);
+}
+
+// Same as SH1106_RenderStrips() but only for the pages whose bits are set in
+// pages (bit 0 is page 0).  With strip NULL the pages are redrawn in the frame
+// buffer instead and left dirty for the next flush.
+int SH1106_RenderPages(uint8_t *strip, SH1106_DrawCallback draw, uint8_t pages)
+{
+    uint8_t saved_lo[SH1106_NUM_PAGES], saved_hi[SH1106_NUM_PAGES];
+    uint8_t *saved_buffer = panel->back_buffer;
+    uint8_t saved_top = clip_top, saved_bottom = clip_bottom;
+    uint8_t page;
+    int retval = I2C_OK;
+
+    if ((strip == NULL) && (panel->back_buffer == NULL))
+    {
+        return I2C_OK;
+    }
+
+    SH1106_WaitFlush();
+    SH1106_RmwInvalidate();
+    SH1106_ApplySettings();
+
+    if (strip != NULL)
+    {
+        memcpy(saved_lo, panel->dirty_lo, sizeof(saved_lo));
+        memcpy(saved_hi, panel->dirty_hi, sizeof(saved_hi));
+        panel->back_buffer = strip;
+    }
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        if (!(pages & (1 << page)))
+        {
+            continue;
+        }
+
+        if (strip != NULL)
+        {
+            base_page = page;
+        }
+        clip_top    = page * NUM_LINES_IN_A_PAGE;
+        clip_bottom = clip_top + NUM_LINES_IN_A_PAGE;
+
+        SH1106_ClearDisplay();
+        draw(page);
+
+        if (strip != NULL)
+        {
+            retval = SH1106_WritePage(panel, page, 0, SH1106_PAGE_WIDTH_BYTES, strip);
+            if (retval != I2C_OK)
+            {
+                break;
+            }
+        }
+    }
+
+    panel->back_buffer = saved_buffer;
+    base_page          = 0;
+    clip_top           = saved_top;
+    clip_bottom        = saved_bottom;
+
+    if (strip != NULL)
+    {
+        memcpy(panel->dirty_lo, saved_lo, sizeof(saved_lo));
+        memcpy(panel->dirty_hi, saved_hi, sizeof(saved_hi));
+        panel->shadow_stale   |= pages;
+        panel->page_crc_valid &= ~pages;
+    }
+
+    return retval;
+}
+
+static void SH1106_FlushComplete(int status);
+
+// Finish an asynchronous flush.
+static void SH1106_FlushDone(bool success)
+{
+    SH1106_EndFlush();
+    flush_busy = false;
+
+    if (flush_callback != NULL)
+    {
+        flush_callback(success);
+    }
+}
+
+// Start the interrupt-driven write of the next run, or finish the flush if there
+// are none left.
+static void SH1106_FlushNext(void)
+{
+    SH1106_Panel *p;
+    uint8_t count;
+    int status;
+
+    if (!SH1106_NextFlush())
+    {
+        SH1106_FlushDone(true);
+        return;
+    }
+
+    p     = flush_panel;
+    count = (flush_run_hi - flush_run_lo) + 1;
+    SH1106_PageHeader(flush_hdr, p->flush_page, (p->column_offset + flush_run_lo));
+
+    p->frame_stats.transactions++;
+    p->frame_stats.overheadBytes += (1 + sizeof(flush_hdr));
+    p->frame_stats.dataBytes     += count;
+
+    status = I2C1_M_WriteAsync(p->address, sizeof(flush_hdr), flush_hdr, count,
+                               &p->front_buffer[SH1106_PAGE_OFFSET(p->flush_page) + flush_run_lo],
+                               SH1106_FlushComplete);
+    if (status != I2C_OK)
+    {
+        SH1106_FlushFailed(p, status);
+        SH1106_FlushDone(false);
+    }
+}
+
+// I2C completion callback (interrupt context) for each run of an asynchronous flush.
+static void SH1106_FlushComplete(int status)
+{
+    if (status != I2C_OK)
+    {
+        // Bus recovery can't be done from the interrupt, so leave this and the
+        // remaining pages latched for the next flush to resume from.
+        SH1106_FlushFailed(flush_panel, status);
+        SH1106_FlushDone(false);
+        return;
+    }
+
+    SH1106_RunSent(flush_panel, flush_panel->flush_page, flush_run_lo, flush_run_hi);
+    flush_runs_done++;
+    SH1106_FlushNext();
+}
+
+// Give up on an asynchronous flush whose transfer never completed.  The run on
+// the bus and the rest stay latched; the bus is left dirty and is recovered at
+// the next flush.
+static void SH1106_FlushStalled(void)
+{
+    I2C1_M_CancelAsync();
+
+    // The flush may have finished before the interrupt was disabled.
+    if (flush_busy)
+    {
+        SH1106_FlushFailed(flush_panel, I2C_Err_TimeoutHW);
+        SH1106_FlushDone(false);
+    }
+}
+
+// Start sending the changed parts of the frame buffer using the I2C master
+// interrupt and return immediately.  Returns false (and sends nothing) if the
+// previous flush is still in progress; the changes remain dirty and are picked up
+// by the next flush.
+//
+// NOTE: the front buffer is read while the transfer is in progress so drawing
+// during the transfer tears unless double buffering is enabled.
+bool SH1106_DisplayAsync(void)
+{
+    if (flush_busy)
+    {
+        return false;
+    }
+
+    SH1106_FlipForFlush();
+
+    flush_busy = true;
+    SH1106_FlushNext();
+
+    return true;
+}
+
+// SH1106_DisplayAsync() for every panel added with SH1106_AddPanel(), interleaving
+// their pages.
+bool SH1106_DisplayAllAsync(void)
+{
+    if (flush_busy)
+    {
+        return false;
+    }
+
+    SH1106_FlipAllForFlush();
+
+    flush_busy = true;
+    SH1106_FlushNext();
+
+    return true;
+}
+
+// Skip sending pages whose CRC shows they haven't changed since they were last
+// sent, for screens that are redrawn in full but rarely change.  Costs a CRC of
+// each dirty page per flush and 18 bytes of state rather than a shadow buffer,
+// plus a resend of the skipped pages every SH1106_PAGE_CRC_REFRESH flips.
+void SH1106_SetPageChecksums(bool enable)
+{
+    SH1106_WaitFlush();
+
+    panel->page_crc_enabled = enable;
+    panel->page_crc_valid   = 0;
+    panel->page_crc_skipped = 0;
+    panel->page_crc_flips   = 0;
+}
+
+bool SH1106_IsFlushBusy(void)
+{
+    return flush_busy;
+}
+
+// Set a function to be called (from interrupt context, or from the waiting caller
+// if the flush stalled) when an asynchronous flush finishes.  The argument is true
+// if every latched page was sent.
+void SH1106_SetFlushCallback(SH1106_FlushCallback callback)
+{
+    flush_callback = callback;
+}
+
+// Bus usage of the selected panel's last flushed frame, including any commands
+// sent to it since the frame before it.
+void SH1106_GetFrameStats(SH1106_FrameStats *stats)
+{
+    SH1106_GetPanelStats(panel, stats);
+}
+
+void SH1106_GetPanelStats(const SH1106_Panel *p, SH1106_FrameStats *stats)
+{
+    *stats = p->last_frame_stats;
+}
+
+// The selected panel's image as last flipped for sending (the frame buffer itself
+// when single buffered).  NULL without a frame buffer.
+const uint8_t *SH1106_GetFrontBuffer(void)
+{
+    return panel->front_buffer;
+}
+
+// Where a flush transfer last failed, if one has since the last call.  Returns
+// false if none has.
+bool SH1106_GetFlushError(SH1106_FlushError *error)
+{
+    if (flush_error.status == I2C_OK)
+    {
+        return false;
+    }
+
+    *error = flush_error;
+    flush_error.status = I2C_OK;
+
+    return true;
+}
+
+// Clear the pages that can currently be drawn to (the whole display, or the
+// current strip inside SH1106_RenderStrips()).
+void SH1106_ClearDisplay(void)
+{
+  if (clip_top >= clip_bottom)
+  {
+    return;
+  }
+
+  uint8_t first_page = clip_top / NUM_LINES_IN_A_PAGE;
+  uint8_t last_page  = (clip_bottom - 1) / NUM_LINES_IN_A_PAGE;
+
+#if !SH1106_USE_FRAMEBUFFER
+  if (panel->back_buffer == NULL)
+  {
+    // Clear the display RAM directly, a block of zeros at a time.
+    uint8_t page, x;
+
+    SH1106_RmwInvalidate();
+    memset(rmw_block, 0, sizeof(rmw_block));
+
+    for (page = first_page; page <= last_page; page++)
+    {
+      for (x = 0; x < SH1106_DISPLAYABLE_WIDTH_PIXELS; x += SH1106_RMW_BLOCK_WIDTH)
+      {
+        SH1106_WritePage(panel, page, x, SH1106_RMW_BLOCK_WIDTH, &rmw_block[1]);
+      }
+    }
+    return;
+  }
+#endif
+
+  memset(SH1106_DRAW_PTR(0, first_page), 0, SH1106_PAGE_OFFSET((last_page - first_page) + 1));
+  SH1106_MarkDirty(0, (SH1106_DISPLAYABLE_WIDTH_PIXELS - 1), clip_top, (clip_bottom - 1));
+}
+
+// Display settings take effect with the next flush (see SH1106_ApplySettings()).
+void SH1106_InvertDisplay(bool invert)
+{
+  SH1106_SetPending(SH1106_CFG_INVERT, (invert ? SH1106_INVERTDISPLAY : SH1106_NORMALDISPLAY));
+}
+
+void SH1106_SetContrast(uint8_t contrast)
+{
+  SH1106_SetPending(SH1106_CFG_CONTRAST, contrast);
+}
+
+void SH1106_SetDisplayOn(bool on)
+{
+  SH1106_SetPending(SH1106_CFG_DISPLAYON, (on ? SH1106_DISPLAYON : SH1106_DISPLAYOFF));
+}
+
+// Scroll the display contents up (lines > 0) or down (lines < 0) by moving the
+// panel's start line rather than redrawing.  The frame buffer becomes a ring:
+// the lines scrolled off one edge come back in at the other, so they're cleared
+// and marked dirty for the caller to draw the new contents into.  Returns the
+// frame buffer line of the first newly exposed line; the |lines| exposed lines
+// follow it, wrapping from the last line back to line 0.
+//
+// The new start line is sent with the next flush, just ahead of the exposed lines.
+int16_t SH1106_Scroll(int8_t lines)
+{
+  uint8_t first, count, i;
+
+  if (lines > SH1106_DISPLAYABLE_HEIGHT_PIXELS)  { lines = SH1106_DISPLAYABLE_HEIGHT_PIXELS; }
+  if (lines < -SH1106_DISPLAYABLE_HEIGHT_PIXELS) { lines = -SH1106_DISPLAYABLE_HEIGHT_PIXELS; }
+
+  if (lines >= 0)
+  {
+    // Lines leaving the top are exposed at the bottom.
+    count             = lines;
+    first             = panel->start_line;
+    panel->start_line = (panel->start_line + count) & (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1);
+  }
+  else
+  {
+    // Lines leaving the bottom are exposed at the top.
+    count             = -lines;
+    panel->start_line = (panel->start_line - count) & (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1);
+    first             = panel->start_line;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    SH1106_DrawFastHLine(0, ((first + i) & (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1)), SH1106_DISPLAYABLE_WIDTH_PIXELS, BLACK);
+  }
+
+  if (count > 0)
+  {
+    SH1106_SetPending(SH1106_CFG_STARTLINE, (SH1106_SETSTARTLINE | panel->start_line));
+  }
+
+  return first;
+}
+
+// Frame buffer line currently shown at the top of the panel.
+uint8_t SH1106_GetStartLine(void)
+{
+  return panel->start_line;
+}
+
+void SH1106_DrawPixel(uint16_t x, uint16_t y, uint16_t color) {
+  if (x >= SH1106_DISPLAYABLE_WIDTH_PIXELS || y < clip_top || y >= clip_bottom)
+  {
+    return;
+  }
+
+  uint8_t *pBuf = SH1106_DRAW_SPAN(x, (y/8), NULL);
+
+  switch (color) 
+  {
+    case WHITE:   *pBuf |=   (1 << (y & 7));     break;
+    case BLACK:   *pBuf &=  ~(1 << (y & 7));     break;
+    case INVERSE: *pBuf ^=   (1 << (y & 7));     break;
+  }  
+
+  SH1106_MarkDirty(x, x, y, y);
+}
+
+// Set up a panel at the given I2C address and add it to the panels flushed by
+// SH1106_DisplayAll().  frame_buffer (SH1106_BUFFER_SIZE_BYTES long, NULL when
+// built without a frame buffer) becomes its back and front buffer.  The panel's
+// settings mirror is left alone so a panel in persistent RAM can be warm started.
+// Select the panel and initialize it before drawing to it.
+void SH1106_AddPanel(SH1106_Panel *p, uint8_t address, uint8_t *frame_buffer, uint8_t rotation)
+{
+    SH1106_Panel *q;
+
+    SH1106_WaitFlush();
+
+    p->address       = address;
+    p->rotation      = rotation;
+    p->column_offset = SH1106_COLUMN_OFFSET;
+    p->shift_y       = 0;
+    p->orbit_step    = 0;
+    p->edge_clear    = 0;
+    p->frame_buffer  = frame_buffer;
+    p->back_buffer   = frame_buffer;
+    p->front_buffer  = frame_buffer;
+    p->shadow_buffer = NULL;
+    p->shadow_stale  = 0xFF;
+    memset(p->dirty_lo, 0xFF, sizeof(p->dirty_lo));
+    memset(p->dirty_hi, 0, sizeof(p->dirty_hi));
+    memset(p->flush_lo, 0xFF, sizeof(p->flush_lo));
+    memset(p->flush_hi, 0, sizeof(p->flush_hi));
+    p->flush_page         = SH1106_NUM_PAGES;
+    p->flushing           = false;
+    p->start_line         = 0;
+    p->pending_mask       = 0;
+    p->page_crc_enabled   = false;
+    p->page_crc_valid     = 0;
+    p->page_crc_skipped   = 0;
+    p->page_crc_flips     = 0;
+    p->config_known       = false;
+    memset(&p->frame_stats, 0, sizeof(p->frame_stats));
+    memset(&p->last_frame_stats, 0, sizeof(p->last_frame_stats));
+
+    for (q = panel_list; q != NULL; q = q->next)
+    {
+        if (q == p)
+        {
+            return;
+        }
+    }
+
+    p->next    = panel_list;
+    panel_list = p;
+    panel_count++;
+}
+
+// Make p the panel that drawing and the other calls act on (NULL selects the
+// default panel).  Returns the panel selected before.
+SH1106_Panel *SH1106_SelectPanel(SH1106_Panel *p)
+{
+    SH1106_Panel *previous = panel;
+
+    if (p == NULL)
+    {
+        p = &default_panel;
+    }
+
+    if (p != panel)
+    {
+        SH1106_RmwInvalidate();
+        panel = p;
+    }
+
+    return previous;
+}
+
+// The default panel is added the first time it's initialized.
+static void SH1106_AddDefaultPanel(void)
+{
+    SH1106_Panel *q;
+
+    if (panel != &default_panel)
+    {
+        return;
+    }
+
+    for (q = panel_list; q != NULL; q = q->next)
+    {
+        if (q == &default_panel)
+        {
+            return;
+        }
+    }
+
+    SH1106_AddPanel(&default_panel, I2C_OLED_ADDRESS, SH1106_DEFAULT_FRAMEBUFFER, SH1106_ROTATE_0);
+}
+
+// Setting the selected panel should have: the default, with the segment and COM
+// scan directions reversed when it's rotated and the display offset following
+// its pixel shift.
+static uint8_t SH1106_PanelSetting(uint8_t setting)
+{
+    if (panel->rotation == SH1106_ROTATE_180)
+    {
+        if (setting == SH1106_CFG_SEGREMAP) { return (SH1106_SEGREMAP | 0x0); }
+        if (setting == SH1106_CFG_COMSCAN)  { return SH1106_COMSCANINC; }
+    }
+
+    if (setting == SH1106_CFG_OFFSET)
+    {
+        // COM0 shows the line shift_y above the top, moving the image down.
+        return (-panel->shift_y) & (SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1);
+    }
+
+    return config_default[setting];
+}
+
+// Turn the selected panel's image upside down (SH1106_ROTATE_180) or back
+// (SH1106_ROTATE_0).  The display RAM is 132 columns centred on the glass so the
+// column offset holds either way.  The new directions and the whole display are
+// sent with the next flush.
+void SH1106_SetRotation(uint8_t rotation)
+{
+    panel->rotation = (rotation == SH1106_ROTATE_180) ? SH1106_ROTATE_180 : SH1106_ROTATE_0;
+
+    SH1106_SetPending(SH1106_CFG_SEGREMAP, SH1106_PanelSetting(SH1106_CFG_SEGREMAP));
+    SH1106_SetPending(SH1106_CFG_COMSCAN, SH1106_PanelSetting(SH1106_CFG_COMSCAN));
+
+    SH1106_InvalidateDisplay();
+}
+
+// Move the selected panel's image dx columns right and dy lines down (dx limited to
+// +/-SH1106_MAX_SHIFT_X) to spread pixel wear.  A vertical shift only changes the
+// panel's display offset, sent with the next flush; lines pushed off one edge
+// wrap round to the other.  The controller can't offset columns, so a horizontal
+// shift moves where pages are written in the display RAM: the columns the image
+// leaves are cleared straight away (or with the next flush if that fails), and
+// only the columns whose contents the move changes are marked dirty (the edges
+// of what's drawn).  The columns brought in are sent straight away too.  Without
+// a frame buffer the whole display is marked for the caller to redraw.
+void SH1106_SetPixelShift(int8_t dx, int8_t dy)
+{
+    uint8_t column_offset, old_col, col, count, page, x, lo, hi;
+    uint8_t zeros[2 * SH1106_MAX_SHIFT_X] = { 0 };
+    uint8_t hdr[sizeof(flush_hdr)];
+    int8_t delta;
+
+    if (dx > SH1106_MAX_SHIFT_X)  { dx = SH1106_MAX_SHIFT_X; }
+    if (dx < -SH1106_MAX_SHIFT_X) { dx = -SH1106_MAX_SHIFT_X; }
+
+    if (dy != panel->shift_y)
+    {
+        panel->shift_y = dy;
+        SH1106_SetPending(SH1106_CFG_OFFSET, SH1106_PanelSetting(SH1106_CFG_OFFSET));
+    }
+
+    column_offset = SH1106_COLUMN_OFFSET + dx;
+    if (column_offset == panel->column_offset)
+    {
+        return;
+    }
+
+    SH1106_WaitFlush();
+    SH1106_RmwInvalidate();
+
+    // Columns uncovered on the left when moving right, or on the right when
+    // moving left.
+    old_col = panel->column_offset;
+    if (column_offset > old_col)
+    {
+        col   = old_col;
+        count = column_offset - old_col;
+    }
+    else
+    {
+        col   = column_offset + SH1106_PAGE_WIDTH_BYTES;
+        count = old_col - column_offset;
+    }
+
+    panel->column_offset = column_offset;
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        SH1106_PageHeader(hdr, page, col);
+        if (SH1106_Write(panel, sizeof(hdr), hdr, count, zeros) != I2C_OK)
+        {
+            // No flush reaches these columns, so SH1106_ApplySettings() retries.
+            panel->edge_clear |= (1 << page);
+        }
+    }
+
+    if (panel->front_buffer == NULL)
+    {
+        SH1106_InvalidateDisplay();
+        return;
+    }
+
+    // Frame buffer column x now shows what column x + delta did.  That's right
+    // where both hold the same byte, unless column x + delta hadn't reached the
+    // panel yet (dirty or latched).  The columns brought in (x + delta off the
+    // image) are sent straight away, like the ones cleared.
+    delta = column_offset - old_col;
+    col   = (delta > 0) ? (SH1106_PAGE_WIDTH_BYTES - delta) : 0;
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        const uint8_t *front = &panel->front_buffer[SH1106_PAGE_OFFSET(page)];
+
+        lo = 0xFF;
+        hi = 0;
+
+        if (SH1106_WritePage(panel, page, col, count, (uint8_t *)&front[col]) != I2C_OK)
+        {
+            // The write may have got part way, so with a shadow copy the whole page
+            // is resent uncompared.
+            lo = col;
+            hi = col + count - 1;
+            panel->shadow_stale |= (1 << page);
+            if (panel->shadow_buffer != NULL)
+            {
+                lo = 0;
+                hi = SH1106_PAGE_WIDTH_BYTES - 1;
+            }
+        }
+
+        for (x = 0; x < SH1106_PAGE_WIDTH_BYTES; x++)
+        {
+            int16_t src = (int16_t)x + delta;
+
+            if ((src < 0) || (src >= SH1106_PAGE_WIDTH_BYTES))
+            {
+                continue;
+            }
+
+            if (((src >= panel->dirty_lo[page]) && (src <= panel->dirty_hi[page])) ||
+                ((src >= panel->flush_lo[page]) && (src <= panel->flush_hi[page])) ||
+                (front[src] != front[x]))
+            {
+                if (x < lo) { lo = x; }
+                if (x > hi) { hi = x; }
+            }
+        }
+
+        if (lo <= hi)
+        {
+            SH1106_MarkDirty(lo, hi, (page * NUM_LINES_IN_A_PAGE), (page * NUM_LINES_IN_A_PAGE));
+        }
+
+        // Move the shadow copy along with the panel's contents.
+        if ((panel->shadow_buffer != NULL) && !(panel->shadow_stale & (1 << page)))
+        {
+            uint8_t *shadow = &panel->shadow_buffer[SH1106_PAGE_OFFSET(page)];
+
+            if (delta > 0)
+            {
+                memmove(shadow, &shadow[delta], (SH1106_PAGE_WIDTH_BYTES - delta));
+            }
+            else
+            {
+                memmove(&shadow[-delta], shadow, (SH1106_PAGE_WIDTH_BYTES + delta));
+            }
+            memcpy(&shadow[col], &front[col], count);
+        }
+    }
+
+    // The pages are no longer where their CRCs were sent.
+    panel->page_crc_valid = 0;
+}
+
+// Move the selected panel's image one step along a small orbit (a path through the
+// 3x3 shifts within a pixel of the centre, there and back again).  Call every few
+// minutes on screens that stay up for long periods.  Most steps are vertical and
+// cost nothing but a command; 4 steps in 16 move sideways and resend the columns
+// the move changes.
+void SH1106_OrbitStep(void)
+{
+    static const int8_t orbit[9][2] = {
+        { -1, -1 }, { -1, 0 }, { -1, 1 },
+        {  0,  1 }, {  0, 0 }, {  0, -1 },
+        {  1, -1 }, {  1, 0 }, {  1, 1 }
+    };
+    uint8_t i;
+
+    panel->orbit_step = (panel->orbit_step + 1) % 16;
+    i = (panel->orbit_step < 9) ? panel->orbit_step : (16 - panel->orbit_step);
+
+    SH1106_SetPixelShift(orbit[i][0], orbit[i][1]);
+}
+
+void SH1106_InitDisplay(void)
+{
+    uint8_t i;
+
+    SH1106_AddDefaultPanel();
+
+    // Initialization sequence for SH1106 (132x64 OLED module), sent as one
+    // transaction with the display turned off until the end.
+    panel->config_known = false;
 
-    // Loop through each page and update the lines in each page.   
-	for (page = 0; page < (SH1106_DISPLAYABLE_HEIGHT_PIXELS / NUM_LINES_IN_A_PAGE); page++)
+    SH1106_BeginCommands();
+    SH1106_QueueCommand(SH1106_DISPLAYOFF);                         // Turn off display.
+    for (i = 0; i < SH1106_CFG_COUNT; i++)
     {
-        SH1106_command(SH1106_SET_PAGEADDRESS | page);  // Set page address.
-        SH1106_command(SH1106_SETLOWCOLUMN  | 0x2);     // Set low column = 2.  NOTE: first two columns aren't displayed.
-        SH1106_command(SH1106_SETHIGHCOLUMN | 0x0);     // Set high column = 0.
-		
-        for(line = 0; line < NUM_LINES_IN_A_PAGE; line++, offset += width_bytes)
-        {   
-            I2C1_M_Write(I2C_OLED_ADDRESS, 0x40, width_bytes, &buffer[offset]);
-        }
-	}
-}
+        SH1106_QueueSetting(i, SH1106_PanelSetting(i));
+    }
 
-void SH1106_ClearDisplay(void)
-{
-  memset(buffer, 0, (SH1106_BUFFER_LINE_WIDTH_BYTES * SH1106_BUFFER_NUM_LINES));
+    panel->config_known = true;
+    SH1106_SendSettings();
+
+    panel->start_line    = 0;
+    panel->pending_mask &= ~(1 << SH1106_CFG_STARTLINE);
+
+    // Panel display RAM contents are unknown after initialization.
+    SH1106_InvalidateDisplay();
 }
 
-void SH1106_InvertDisplay(bool invert)
+// Bring the panel up after a reset (ex: watchdog) without re-initializing it when
+// it's still on and its settings are known from before the reset.  The defaults
+// (for its rotation) become pending settings rather than being sent, so settings
+// changed before the next flush (ex: SH1106_InvertDisplay()) replace them, and the
+// flush sends only those the panel doesn't already have.  The panel keeps showing
+// its last image until then.  Falls back to SH1106_InitDisplay() when the status
+// read fails, the panel is off (it was power cycled) or the settings mirror didn't
+// survive the reset.  Returns true for a warm start.
+bool SH1106_WarmStart(void)
 {
-  SH1106_command((invert ? SH1106_INVERTDISPLAY : SH1106_NORMALDISPLAY));
-}
+    uint8_t status, i;
 
-void SH1106_DrawPixel(uint16_t x, uint16_t y, uint16_t color) {
-  if (x >= SH1106_DISPLAYABLE_WIDTH_PIXELS || y >= SH1106_DISPLAYABLE_HEIGHT_PIXELS)
-  {
-    return;
-  }
+    SH1106_AddDefaultPanel();
 
-  switch (color) 
-  {
-    case WHITE:   buffer[x  + (y/8) * SH1106_DISPLAYABLE_WIDTH_PIXELS] |=   (1 << (y & 7));     break;
-    case BLACK:   buffer[x  + (y/8) * SH1106_DISPLAYABLE_WIDTH_PIXELS] &=  ~(1 << (y & 7));     break;
-    case INVERSE: buffer[x  + (y/8) * SH1106_DISPLAYABLE_WIDTH_PIXELS] ^=   (1 << (y & 7));     break;
-  }  
+    if ((I2C1_M_Read(panel->address, SH1106_CONTROL_COMMAND_STREAM, 1, &status) != I2C_OK) ||
+        (status & SH1106_STATUS_DISPLAYOFF) ||
+        (panel->config_check != SH1106_ConfigCheck()))
+    {
+        SH1106_InitDisplay();
+        return false;
+    }
+
+    panel->config_known = true;
+
+    for (i = 0; i < SH1106_CFG_COUNT; i++)
+    {
+        SH1106_SetPending(i, SH1106_PanelSetting(i));
+    }
+
+    panel->start_line = 0;
+
+    // The frame buffer doesn't hold what the panel shows.
+    SH1106_InvalidateDisplay();
+
+    return true;
 }
 
-void SH1106_InitDisplay(void)
+// Send a full screen image (SH1106_NUM_PAGES pages of SH1106_PAGE_WIDTH_BYTES, laid
+// out like the frame buffer) straight from flash to the panel, one page per
+// transaction, without going through RAM.  Pending settings are sent first.  The
+// image stays up until the next flush, which resends the whole frame buffer.
+int SH1106_DrawSplash(const uint8_t *image)
 {
-    // Initialization sequence for SH1106 (132x64 OLED module).
-    SH1106_command(SH1106_DISPLAYOFF);                      // Turn off display.
-    SH1106_command(SH1106_SETDISPLAYCLOCKDIV);              // Set clock divider.
-    SH1106_command(0x50);                                   // PoR value is 0x50.
-    SH1106_command(SH1106_SETMULTIPLEX);                    // Set multiplex mode ratio.
-    SH1106_command(0x3F);                                   // PoR value is 0x3F (63).
-    SH1106_command(SH1106_SETDISPLAYOFFSET);                // Set mapping display start line.
-    SH1106_command(0x00);                                   // PoR value ix 0x0.
-    SH1106_command(SH1106_SETSTARTLINE | 0x0);              // Set COM0 display line to 0.
-    SH1106_command(SH1106_SEGREMAP | 0x1);                  // Set segment re-map to left rotation.
-    SH1106_command(SH1106_COMSCANDEC);
-    SH1106_command(SH1106_SETCOMPINS);
-    SH1106_command(0x12);
-    SH1106_command(SH1106_SETCONTRAST);
-    SH1106_command(0x80);
-    SH1106_command(SH1106_SETPRECHARGE);
-    SH1106_command(0x22);
-    SH1106_command(SH1106_SETVCOMDETECT);
-    SH1106_command(0x40);
-    SH1106_command(SH1106_DISPLAYALLON_RESUME);
-    SH1106_command(SH1106_NORMALDISPLAY);
-    
-    SH1106_command(SH1106_DISPLAYON);
+    uint8_t page;
+    int retval = I2C_OK;
+
+    SH1106_WaitFlush();
+    SH1106_RmwInvalidate();
+    SH1106_ApplySettings();
+
+    for (page = 0; page < SH1106_NUM_PAGES; page++)
+    {
+        retval = SH1106_WritePage(panel, page, 0, SH1106_PAGE_WIDTH_BYTES, (uint8_t *)&image[SH1106_PAGE_OFFSET(page)]);
+        if (retval != I2C_OK)
+        {
+            break;
+        }
+    }
+
+    SH1106_InvalidateDisplay();
+
+    return retval;
 }
 
-static void SH1106_DrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+// Horizontal and vertical lines, clipped.  Like SH1106_DrawPixel() these draw
+// directly and aren't recorded into a display list.
+void SH1106_DrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
 {
   // Do bounds/limit checks
-  if(y < 0 || y >= SH1106_DISPLAYABLE_HEIGHT_PIXELS) { return; }
+  if(y < clip_top || y >= clip_bottom) { return; }
 
   // make sure we don't try to draw below 0
   if(x < 0) { 
@@ -121,39 +1842,47 @@ static void SH1106_DrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color
   // if our width is now negative, punt
   if(w <= 0) { return; }
 
-  // set up the pointer for  movement through the buffer
-  register uint8_t *pBuf = buffer;
-  // adjust the buffer pointer for the current row
-  pBuf += ((y/8) * SH1106_DISPLAYABLE_WIDTH_PIXELS);
-  // and offset x columns in
-  pBuf += x;
+  SH1106_MarkDirty(x, (x + w - 1), y, y);
 
   register uint8_t mask = 1 << (y&7);
 
-  switch (color) 
-  {
-    case WHITE:   while(w--) { *pBuf++ |= mask; }; break;
-    case BLACK:   mask = ~mask;   while(w--) { *pBuf++ &= mask; }; break;
-    case INVERSE: while(w--) { *pBuf++ ^= mask; }; break;
+  // Drawing into the display RAM cache takes one block at a time, otherwise the
+  // whole line is done in one pass.
+  while(w > 0) {
+    uint8_t n = w;
+
+    // set up the pointer for  movement through the buffer, at the current row and
+    // offset x columns in
+    register uint8_t *pBuf = SH1106_DRAW_SPAN(x, (y/8), &n);
+
+    x += n;
+    w -= n;
+
+    switch (color) 
+    {
+      case WHITE:   while(n--) { *pBuf++ |= mask; }; break;
+      case BLACK:   while(n--) { *pBuf++ &= ~mask; }; break;
+      case INVERSE: while(n--) { *pBuf++ ^= mask; }; break;
+    }
   }
 }
 
-static void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t color) {
+void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t color) {
 
   // do nothing if we're off the left or right side of the screen
   if(x < 0 || x >= SH1106_DISPLAYABLE_WIDTH_PIXELS) { return; }
 
-  // make sure we don't try to draw below 0
-  if(__y < 0) { 
-    // __y is negative, this will subtract enough from __h to account for __y being 0
-    __h += __y;
-    __y = 0;
+  // make sure we don't try to draw above the clip region
+  if(__y < clip_top) { 
+    // this will subtract enough from __h to account for __y being clip_top
+    __h -= (clip_top - __y);
+    __y = clip_top;
 
   } 
 
-  // make sure we don't go past the height of the display
-  if( (__y + __h) > SH1106_DISPLAYABLE_HEIGHT_PIXELS) { 
-    __h = (SH1106_DISPLAYABLE_HEIGHT_PIXELS - __y);
+  // make sure we don't go past the bottom of the clip region
+  if( (__y + __h) > clip_bottom) { 
+    __h = (clip_bottom - __y);
   }
 
   // if our height is now negative, punt 
@@ -165,13 +1894,13 @@ static void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t c
   register uint8_t y = __y;
   register uint8_t h = __h;
 
+  SH1106_MarkDirty(x, x, y, (y + h - 1));
+
 
-  // set up the pointer for fast movement through the buffer
-  register uint8_t *pBuf = buffer;
-  // adjust the buffer pointer for the current row
-  pBuf += ((y/8) * SH1106_DISPLAYABLE_WIDTH_PIXELS);
+  // set up the pointer for fast movement through the buffer, at the current row
   // and offset x columns in
-  pBuf += x;
+  register uint8_t page = y/8;
+  register uint8_t *pBuf = SH1106_DRAW_SPAN(x, page, NULL);
 
   // do the first partial byte, if necessary - this requires some masking
   register uint8_t mod = (y&7);
@@ -197,11 +1926,11 @@ static void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t c
     }
   
     // fast exit if we're done here!
-    if(h<mod) { return; }
+    if(h<=mod) { return; }
 
     h -= mod;
 
-    pBuf += SH1106_DISPLAYABLE_WIDTH_PIXELS;
+    pBuf = SH1106_DRAW_SPAN(x, ++page, NULL);
   }
 
 
@@ -211,11 +1940,11 @@ static void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t c
       do  {
       *pBuf=~(*pBuf);
 
-        // adjust the buffer forward 8 rows worth of data
-        pBuf += SH1106_DISPLAYABLE_WIDTH_PIXELS;
-
         // adjust h & y (there's got to be a faster way for me to do this, but this should still help a fair bit for now)
         h -= 8;
+
+        // adjust the buffer forward 8 rows worth of data, unless there's nothing left
+        if(h) { pBuf = SH1106_DRAW_SPAN(x, ++page, NULL); }
       } while(h >= 8);
       }
     else {
@@ -226,11 +1955,11 @@ static void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t c
         // write our value in
       *pBuf = val;
 
-        // adjust the buffer forward 8 rows worth of data
-        pBuf += SH1106_DISPLAYABLE_WIDTH_PIXELS;
-
         // adjust h & y (there's got to be a faster way for me to do this, but this should still help a fair bit for now)
         h -= 8;
+
+        // adjust the buffer forward 8 rows worth of data, unless there's nothing left
+        if(h) { pBuf = SH1106_DRAW_SPAN(x, ++page, NULL); }
       } while(h >= 8);
       }
     }
@@ -252,41 +1981,175 @@ static void SH1106_DrawFastVLine(int16_t x, int16_t __y, int16_t __h, uint16_t c
   }
 }
 
+// Midpoint circle in integer arithmetic, stepping one octant and mirroring it.  A
+// filled circle is one vertical span per column and an outline one pixel per
+// point; either way nothing is drawn twice, so INVERSE works.
 void SH1106_DrawCircle (uint8_t x, uint8_t y, uint8_t r, uint16_t color, bool fill)
 {
-    int8_t mx = 0;
-    int8_t my;
-    
+    if (SH1106_DL_IsRecording())
+    {
+        SH1106_DL_AddCircle(x, y, r, color, fill);
+        return;
+    }
+
+    int16_t mx = 0;
+    int16_t my = r;
+    int16_t err = 1 - r;        // Midpoint decision: >= 0 once the point is outside
+    int16_t px = 0;             // Last point whose my columns aren't drawn yet
+    int16_t py = r;
+
     if (fill)
     {
-        for (mx=r ; mx>=-r ; mx--)
+        SH1106_DrawFastVLine(x, (y - r), ((2 * r) + 1), color);
+    }
+    else if (r == 0)
+    {
+        SH1106_DrawPixel(x, y, color);
+        return;
+    }
+    else
+    {
+        SH1106_DrawPixel(x, (y - r), color);
+        SH1106_DrawPixel(x, (y + r), color);
+        SH1106_DrawPixel((x - r), y, color);
+        SH1106_DrawPixel((x + r), y, color);
+    }
+
+    while (mx < my)
+    {
+        if (err >= 0)
+        {
+            my--;
+            err -= 2 * my;
+        }
+        mx++;
+        err += (2 * mx) + 1;
+
+        if (fill)
+        {
+            // Columns x +/- mx reach to my; columns x +/- py reach to px, the
+            // last mx before my moved off py.
+            if (mx <= my)
+            {
+                SH1106_DrawFastVLine((x + mx), (y - my), ((2 * my) + 1), color);
+                SH1106_DrawFastVLine((x - mx), (y - my), ((2 * my) + 1), color);
+            }
+            if ((my != py) && (py > px))
+            {
+                SH1106_DrawFastVLine((x + py), (y - px), ((2 * px) + 1), color);
+                SH1106_DrawFastVLine((x - py), (y - px), ((2 * px) + 1), color);
+            }
+            px = mx;
+            py = my;
+        }
+        else if (mx <= my)
         {
-            my = sqrt(r*r - mx*mx);
-            SH1106_DrawFastVLine((x+mx), (y-my), (my*2), color);
+            SH1106_DrawPixel((x + mx), (y - my), color);
+            SH1106_DrawPixel((x - mx), (y - my), color);
+            SH1106_DrawPixel((x + mx), (y + my), color);
+            SH1106_DrawPixel((x - mx), (y + my), color);
+
+            // On the diagonal the other octants give the same points.
+            if (mx != my)
+            {
+                SH1106_DrawPixel((x + my), (y - mx), color);
+                SH1106_DrawPixel((x - my), (y - mx), color);
+                SH1106_DrawPixel((x + my), (y + mx), color);
+                SH1106_DrawPixel((x - my), (y + mx), color);
+            }
         }
     }
-    else
+}
+
+// Invert n bytes, a word at a time where aligned (like memset() for INVERSE).
+static void SH1106_InvertBytes(uint8_t *pBuf, uint8_t n)
+{
+    typedef uint16_t __attribute__((__may_alias__)) word_t;
+    word_t *pWord;
+
+    if (((uintptr_t)pBuf & 1) && n)
+    {
+        *pBuf++ ^= 0xFF;
+        n--;
+    }
+
+    for (pWord = (word_t *)pBuf; n >= 2; n -= 2)
+    {
+        *pWord++ ^= 0xFFFF;
+    }
+
+    if (n)
     {
-        float radians = 0;
-        // Step by 4 radians to save time...
-        for (radians=0 ; radians < TWO_PI ; radians += (4.0 * ONE_RADIAN))
+        *(uint8_t *)pWord ^= 0xFF;
+    }
+}
+
+// Fill a rectangle (clipped) a page at a time.  Each byte gets the mask of the
+// rectangle's lines in its page, so a byte is touched once rather than once per
+// line, and bytes the rectangle covers completely are set or cleared outright.
+static void SH1106_FillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    uint8_t page, first_page, last_page, mask, n;
+    int16_t col, left;
+    uint8_t *pBuf;
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < clip_top) { h -= (clip_top - y); y = clip_top; }
+    if ((x + w) > SH1106_DISPLAYABLE_WIDTH_PIXELS) { w = SH1106_DISPLAYABLE_WIDTH_PIXELS - x; }
+    if ((y + h) > clip_bottom) { h = clip_bottom - y; }
+    if ((w <= 0) || (h <= 0))
+    {
+        return;
+    }
+
+    first_page = y / NUM_LINES_IN_A_PAGE;
+    last_page  = (y + h - 1) / NUM_LINES_IN_A_PAGE;
+
+    for (page = first_page; page <= last_page; page++)
+    {
+        mask = 0xFF;
+        if (page == first_page) { mask &= (0xFF << (y & 7)); }
+        if (page == last_page)  { mask &= (0xFF >> (7 - ((y + h - 1) & 7))); }
+
+        // Drawing into the display RAM cache takes one block at a time, otherwise
+        // the page's columns are done in one pass.
+        for (col = x, left = w; left > 0; col += n, left -= n)
         {
-            uint8_t mx =   (x + (r * cos(radians)));
-            uint8_t my =   (y + (r * sin(radians)));
-            SH1106_DrawPixel(mx, my, color);
+            n = left;
+            pBuf = SH1106_DRAW_SPAN(col, page, &n);
+
+            switch (color)
+            {
+                case WHITE:
+                    if (mask == 0xFF) { memset(pBuf, 0xFF, n); }
+                    else              { uint8_t i = n; while (i--) { *pBuf++ |= mask; } }
+                    break;
+                case BLACK:
+                    if (mask == 0xFF) { memset(pBuf, 0x00, n); }
+                    else              { uint8_t i = n; while (i--) { *pBuf++ &= ~mask; } }
+                    break;
+                case INVERSE:
+                    if (mask == 0xFF) { SH1106_InvertBytes(pBuf, n); }
+                    else              { uint8_t i = n; while (i--) { *pBuf++ ^= mask; } }
+                    break;
+            }
         }
     }
+
+    SH1106_MarkDirty(x, (x + w - 1), y, (y + h - 1));
 }
 
 void SH1106_DrawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color, bool fill)
 {
+    if (SH1106_DL_IsRecording())
+    {
+        SH1106_DL_AddRect(x, y, w, h, color, fill);
+        return;
+    }
+
     if (fill)
     {
-        uint8_t my = 0;
-        for (my=0 ; my<h ; my++)
-        {
-            SH1106_DrawFastHLine(x, y+my, w, color);
-        }
+        SH1106_FillRect(x, y, w, h, color);
     }
     else
     {
@@ -297,19 +2160,44 @@ void SH1106_DrawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color,
     }
 }
 
-/**************************************************************************/
-/*!
-   @brief    Write a line.  Bresenham's algorithm - thx wikpedia
-    @param    x0  Start point x coordinate
-    @param    y0  Start point y coordinate
-    @param    x1  End point x coordinate
-    @param    y1  End point y coordinate
-    @param    color 16-bit 5-6-5 Color to draw with
-*/
-/**************************************************************************/
+// Draw a line from (x0,y0) to (x1,y1) with Bresenham's algorithm, clipped to the
+// display and the current clip rows.  Horizontal and vertical lines go to the
+// fast line routines.  Otherwise the range of steps inside the clip region is
+// worked out once, the error term is advanced to the first of them, and the line
+// is walked through the frame buffer a byte and bit mask at a time, marking the
+// columns it covers in each page dirty.  Clipping this way picks exactly the pixels the whole
+// line would, so lines drawn a page strip at a time join up.
 void SH1106_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
 {
-  int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+  if (SH1106_DL_IsRecording()) {
+    SH1106_DL_AddLine(x0, y0, x1, y1, color);
+    return;
+  }
+
+  // Horizontal and vertical lines are cut to the display first so their length
+  // can't overflow.
+  if (y0 == y1) {
+    if (x0 > x1) { sh1106_swap(x0, x1); }
+    if (x0 < 0) { x0 = 0; }
+    if (x1 >= SH1106_DISPLAYABLE_WIDTH_PIXELS) { x1 = SH1106_DISPLAYABLE_WIDTH_PIXELS - 1; }
+    if (x0 <= x1) { SH1106_DrawFastHLine(x0, y0, (x1 - x0 + 1), color); }
+    return;
+  }
+  if (x0 == x1) {
+    if (y0 > y1) { sh1106_swap(y0, y1); }
+    if (y0 < 0) { y0 = 0; }
+    if (y1 >= SH1106_DISPLAYABLE_HEIGHT_PIXELS) { y1 = SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1; }
+    if (y0 <= y1) { SH1106_DrawFastVLine(x0, y0, (y1 - y0 + 1), color); }
+    return;
+  }
+
+  if (clip_top >= clip_bottom) {
+    return;
+  }
+
+  // Step along the major axis u, the minor axis v moving by vstep when the error
+  // runs out.  Both deltas are at least 1 from here on.
+  bool steep = labs((int32_t)y1 - y0) > labs((int32_t)x1 - x0);
   if (steep) {
     sh1106_swap(x0, y0);
     sh1106_swap(x1, y1);
@@ -320,29 +2208,485 @@ void SH1106_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t co
     sh1106_swap(y0, y1);
   }
 
-  int16_t dx, dy;
-  dx = x1 - x0;
-  dy = abs(y1 - y0);
-
-  int16_t err = dx / 2;
-  int16_t ystep;
+  uint16_t du = (uint16_t)x1 - (uint16_t)x0;
+  uint16_t dv = (y1 > y0) ? ((uint16_t)y1 - (uint16_t)y0) : ((uint16_t)y0 - (uint16_t)y1);
+  int8_t vstep = (y1 > y0) ? 1 : -1;
+  uint16_t e0 = du / 2;
 
-  if (y0 < y1) {
-    ystep = 1;
+  // Clip region along each axis.
+  int16_t umin, umax, vmin, vmax;
+  if (steep) {
+    umin = clip_top;  umax = clip_bottom - 1;
+    vmin = 0;         vmax = SH1106_DISPLAYABLE_WIDTH_PIXELS - 1;
   } else {
-    ystep = -1;
+    umin = 0;         umax = SH1106_DISPLAYABLE_WIDTH_PIXELS - 1;
+    vmin = clip_top;  vmax = clip_bottom - 1;
+  }
+
+  // Range of steps k (0..du) inside the clip region.  At step k the minor axis
+  // has moved q(k) = (k * dv + du - 1 - e0) / du times, so the steps where q(k)
+  // is within qa..qb follow directly.
+  int32_t kfirst = 0, klast = du;
+  int32_t qa = (vstep > 0) ? ((int32_t)vmin - y0) : ((int32_t)y0 - vmax);
+  int32_t qb = (vstep > 0) ? ((int32_t)vmax - y0) : ((int32_t)y0 - vmin);
+
+  if ((qb < 0) || (qa > dv)) {
+    return;
+  }
+  if (((int32_t)umin - x0) > kfirst) { kfirst = (int32_t)umin - x0; }
+  if (((int32_t)umax - x0) < klast)  { klast  = (int32_t)umax - x0; }
+  if (qa > 0) {
+    int32_t k = (((uint32_t)qa * du) - (du - 1 - e0) + (dv - 1)) / dv;
+    if (k > kfirst) { kfirst = k; }
   }
+  if (qb < dv) {
+    int32_t k = (((uint32_t)qb * du) + e0) / dv;
+    if (k < klast) { klast = k; }
+  }
+  if (kfirst > klast) {
+    return;
+  }
+
+  // Position and error at the first visible step.  The error stays within 0..du-1.
+  uint16_t q   = (((uint32_t)kfirst * dv) + (du - 1 - e0)) / du;
+  uint16_t err = (((uint32_t)q * du) + e0) - ((uint32_t)kfirst * dv);
+  uint8_t n    = (klast - kfirst) + 1;
+  uint8_t u    = x0 + kfirst;
+  uint8_t v    = y0 + ((vstep > 0) ? q : -q);
+
+  // Bits to clear and to toggle: WHITE clears then toggles (sets), BLACK clears,
+  // INVERSE toggles.
+  uint8_t clr = (color == WHITE || color == BLACK) ? 0xFF : 0;
+  uint8_t tog = (color == WHITE || color == INVERSE) ? 0xFF : 0;
+
+  uint8_t x, y, page, mask, bits, lo, hi;
+  uint8_t *pBuf;
+
+  if (!steep) {
+    // One pixel per column.  The column range drawn in each page is marked dirty
+    // on leaving it.
+    x = lo = u;
+    y = v;
+    page = y / 8;
+    mask = 1 << (y & 7);
+    pBuf = SH1106_DRAW_SPAN(x, page, NULL);
+
+    while (true) {
+      *pBuf = (*pBuf & ~(mask & clr)) ^ (mask & tog);
+
+      if (--n == 0) {
+        break;
+      }
+
+      x++;
+      if (err < dv) {
+        err += du - dv;
+        if (vstep > 0) {
+          mask <<= 1;
+          if (mask == 0) { SH1106_MarkDirty(lo, (x - 1), y, y); lo = x; mask = 0x01; page++; }
+        } else {
+          mask >>= 1;
+          if (mask == 0) { SH1106_MarkDirty(lo, (x - 1), y, y); lo = x; mask = 0x80; page--; }
+        }
+        y += vstep;
+      } else {
+        err -= dv;
+      }
 
-  for (; x0 <= x1; x0++) {
-    if (steep) {
-      SH1106_DrawPixel(y0, x0, color);
-    } else {
-      SH1106_DrawPixel(x0, y0, color);
+#if SH1106_USE_FRAMEBUFFER
+      pBuf = SH1106_DRAW_PTR(x, page);
+#else
+      pBuf = SH1106_DRAW_SPAN(x, page, NULL);
+#endif
     }
-    err -= dy;
-    if (err < 0) {
-      y0 += ystep;
-      err += dx;
+
+    SH1106_MarkDirty(lo, x, y, y);
+  } else {
+    // Runs of lines in the same column and page share a byte, so collect their
+    // bits and write the byte once.
+    x = lo = hi = v;
+    y = u;
+    page = y / 8;
+    mask = 1 << (y & 7);
+    bits = 0;
+    pBuf = SH1106_DRAW_SPAN(x, page, NULL);
+
+    while (true) {
+      bits |= mask;
+
+      if (--n == 0) {
+        break;
+      }
+
+      y++;
+      mask <<= 1;
+      if ((err < dv) || (mask == 0)) {
+        *pBuf = (*pBuf & ~(bits & clr)) ^ (bits & tog);
+        bits = 0;
+
+        if (mask == 0) {
+          SH1106_MarkDirty(lo, hi, (y - 1), (y - 1));
+        }
+        if (err < dv) {
+          x += vstep;
+        }
+        if (mask == 0) {
+          mask = 0x01;
+          page++;
+          lo = hi = x;
+        } else {
+          if (x < lo) { lo = x; }
+          if (x > hi) { hi = x; }
+        }
+
+        pBuf = SH1106_DRAW_SPAN(x, page, NULL);
+      }
+
+      if (err < dv) {
+        err += du - dv;
+      } else {
+        err -= dv;
+      }
     }
+
+    *pBuf = (*pBuf & ~(bits & clr)) ^ (bits & tog);
+    SH1106_MarkDirty(lo, hi, y, y);
   }
 }
+
+// Integer stepping along a triangle edge one column at a time: y is the edge's
+// line (rounded) at the current column, carried as whole lines plus a fraction
+// err / dx.
+typedef struct {
+    int16_t y;
+    int16_t step;           // Whole lines per column
+    uint16_t rem;           // Fraction per column, in 1/dx
+    uint16_t err;
+    uint16_t dx;
+} SH1106_Edge;
+
+// Start stepping the edge x0,y0 - x1,y1 (x1 > x0) at column x.
+static void SH1106_EdgeStart(SH1106_Edge *e, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x)
+{
+    int32_t dx = (int32_t)x1 - x0;
+    int32_t dy = (int32_t)y1 - y0;
+    int32_t n  = (((int32_t)x - x0) * dy) + (dx / 2);
+    int32_t q  = n / dx;
+    int32_t s  = dy / dx;
+
+    // Round the divisions down rather than towards zero.
+    if ((q * dx) > n)  { q--; }
+    if ((s * dx) > dy) { s--; }
+
+    e->y    = y0 + q;
+    e->err  = n - (q * dx);
+    e->step = s;
+    e->rem  = dy - (s * dx);
+    e->dx   = dx;
+}
+
+static void SH1106_EdgeStep(SH1106_Edge *e)
+{
+    e->y   += e->step;
+    e->err += e->rem;
+    if (e->err >= e->dx)
+    {
+        e->err -= e->dx;
+        e->y++;
+    }
+}
+
+// Draw lines ya-yb (either order) of column x, clipped.
+static void SH1106_DrawSpan(int16_t x, int16_t ya, int16_t yb, uint16_t color)
+{
+    if (ya > yb) { sh1106_swap(ya, yb); }
+    if (ya < 0) { ya = 0; }
+    if (yb >= SH1106_DISPLAYABLE_HEIGHT_PIXELS) { yb = SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1; }
+    if (ya <= yb)
+    {
+        SH1106_DrawFastVLine(x, ya, ((yb - ya) + 1), color);
+    }
+}
+
+// Triangle outline, or filled as one vertical span per column (bytes of a column
+// are consecutive lines, so a span is a few byte writes).  The vertices are sorted
+// by x and the long edge and the two short ones stepped across in integers.  A
+// filled triangle draws each pixel once, so INVERSE works.  Vertices must be
+// within 16383 pixels of each other.
+void SH1106_DrawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool fill)
+{
+    SH1106_Edge edge_long, edge_short;
+    int16_t x, x_first, x_last;
+
+    if (SH1106_DL_IsRecording())
+    {
+        SH1106_DL_AddTriangle(x0, y0, x1, y1, x2, y2, color, fill);
+        return;
+    }
+
+    if (!fill)
+    {
+        SH1106_DrawLine(x0, y0, x1, y1, color);
+        SH1106_DrawLine(x1, y1, x2, y2, color);
+        SH1106_DrawLine(x2, y2, x0, y0, color);
+        return;
+    }
+
+    if (x0 > x1) { sh1106_swap(x0, x1); sh1106_swap(y0, y1); }
+    if (x1 > x2) { sh1106_swap(x1, x2); sh1106_swap(y1, y2); }
+    if (x0 > x1) { sh1106_swap(x0, x1); sh1106_swap(y0, y1); }
+
+    if ((x2 < 0) || (x0 >= SH1106_DISPLAYABLE_WIDTH_PIXELS))
+    {
+        return;
+    }
+
+    // All in one column.
+    if (x0 == x2)
+    {
+        if (y0 > y1) { sh1106_swap(y0, y1); }
+        if (y1 > y2) { sh1106_swap(y1, y2); }
+        if (y0 > y1) { sh1106_swap(y0, y1); }
+        SH1106_DrawSpan(x0, y0, y2, color);
+        return;
+    }
+
+    x_first = (x0 < 0) ? 0 : x0;
+    x_last  = (x2 >= SH1106_DISPLAYABLE_WIDTH_PIXELS) ? (SH1106_DISPLAYABLE_WIDTH_PIXELS - 1) : x2;
+
+    // Each column spans from the long edge (x0 to x2) to the short edge on its
+    // side of x1; column x1 reaches the middle vertex itself.
+    SH1106_EdgeStart(&edge_long, x0, y0, x2, y2, x_first);
+    if (x_first < x1)
+    {
+        SH1106_EdgeStart(&edge_short, x0, y0, x1, y1, x_first);
+    }
+
+    for (x = x_first; x <= x_last; x++)
+    {
+        if (x < x1)
+        {
+            SH1106_DrawSpan(x, edge_long.y, edge_short.y, color);
+            SH1106_EdgeStep(&edge_short);
+        }
+        else if (x == x1)
+        {
+            SH1106_DrawSpan(x, edge_long.y, y1, color);
+            if (x1 < x2)
+            {
+                SH1106_EdgeStart(&edge_short, x1, y1, x2, y2, x);
+                SH1106_EdgeStep(&edge_short);
+            }
+        }
+        else
+        {
+            if (x == x_first)
+            {
+                SH1106_EdgeStart(&edge_short, x1, y1, x2, y2, x);
+            }
+            SH1106_DrawSpan(x, edge_long.y, edge_short.y, color);
+            SH1106_EdgeStep(&edge_short);
+        }
+
+        SH1106_EdgeStep(&edge_long);
+    }
+}
+
+// Polygon edge for the column scan.  It crosses columns x0 to x1 - 1, and y is
+// the first line on or below where it crosses the current column.  The crossing
+// itself is y - err / dx, stepped in integers as in SH1106_Edge.
+typedef struct {
+    int16_t x0, x1;
+    int16_t y;
+    int16_t step;           // Whole lines per column
+    uint16_t rem;           // Fraction per column, in 1/dx
+    uint16_t err;
+    uint16_t dx;
+    int8_t dir;             // 1 if the edge runs left to right, -1 if right to left
+} SH1106_PolyEdge;
+
+// Move the edge on by k columns.
+static void SH1106_PolyEdgeStep(SH1106_PolyEdge *e, uint16_t k)
+{
+    uint32_t n = ((uint32_t)k * e->rem) + e->dx - 1 - e->err;
+    uint16_t q = n / e->dx;
+
+    e->y  += ((int16_t)k * e->step) + q;
+    e->err = (e->dx - 1) - (n - ((uint32_t)q * e->dx));
+}
+
+// Draw lines y0 down to (not including) y1 of column x, clipped.
+static void SH1106_PolySpan(int16_t x, int16_t y0, int16_t y1, uint16_t color)
+{
+    int16_t ya = y0;
+    int16_t yb = y1 - 1;
+
+    if (ya < 0) { ya = 0; }
+    if (yb >= SH1106_DISPLAYABLE_HEIGHT_PIXELS) { yb = SH1106_DISPLAYABLE_HEIGHT_PIXELS - 1; }
+    if (ya <= yb)
+    {
+        SH1106_DrawFastVLine(x, ya, ((yb - ya) + 1), color);
+    }
+}
+
+// Polygon outline (mode SH1106_POLY_OUTLINE), or filled by the even-odd or
+// non-zero winding rule.  The fill scans columns rather than rows so each run
+// inside the polygon is one vertical span, as in SH1106_DrawTriangle().  Edges
+// wait in a table sorted by first column, join the active list when the scan
+// reaches them and leave it after their last column; the active list is sorted
+// by where the edges cross the column and the spans lie between crossings.
+//
+// Pixels are sampled at their centres and those on the right and bottom of the
+// boundary are left out, so polygons sharing an edge don't overlap and a fill
+// draws each pixel once (INVERSE works).  Edges are stepped in integers, so the
+// fill is exact at any size.  Coordinates must be within -2048 to 2047.  A fill
+// with more than SH1106_POLY_MAX_POINTS vertices draws nothing; outlines take any
+// number.  A display list keeps the points pointer, not a copy of the points.
+void SH1106_DrawPolygon(const SH1106_Point *points, uint8_t count, uint16_t color, uint8_t mode)
+{
+    SH1106_PolyEdge edges[SH1106_POLY_MAX_POINTS];
+    uint8_t active[SH1106_POLY_MAX_POINTS];
+    uint8_t num_edges = 0, num_active = 0, next = 0;
+    int16_t x, x_first, x_last, xmin, xmax;
+    int16_t top = 0;
+    int8_t winding;
+    uint8_t i, j;
+
+    if (SH1106_DL_IsRecording())
+    {
+        SH1106_DL_AddPolygon(points, count, color, mode);
+        return;
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (mode == SH1106_POLY_OUTLINE)
+    {
+        for (i = 0; i < count; i++)
+        {
+            const SH1106_Point *b = &points[((i + 1) < count) ? (i + 1) : 0];
+
+            SH1106_DrawLine(points[i].x, points[i].y, b->x, b->y, color);
+        }
+        return;
+    }
+
+    if (count > SH1106_POLY_MAX_POINTS)
+    {
+        return;
+    }
+
+    // Build the edge table.  Edges within one column never cross a column's
+    // centre line so they're left out.
+    xmin = xmax = points[0].x;
+    for (i = 0; i < count; i++)
+    {
+        const SH1106_Point *a = &points[i];
+        const SH1106_Point *b = &points[((i + 1) < count) ? (i + 1) : 0];
+        SH1106_PolyEdge e;
+        int16_t dx, dy, s;
+
+        if (a->x < xmin) { xmin = a->x; }
+        if (a->x > xmax) { xmax = a->x; }
+
+        if (a->x == b->x)
+        {
+            continue;
+        }
+
+        if (a->x > b->x)
+        {
+            const SH1106_Point *t = a;
+            a = b;
+            b = t;
+            e.dir = -1;
+        }
+        else
+        {
+            e.dir = 1;
+        }
+
+        dx = b->x - a->x;
+        dy = b->y - a->y;
+        s  = dy / dx;
+
+        // Round the whole lines down so the fraction is positive.
+        if ((s * dx) > dy) { s--; }
+
+        e.x0   = a->x;
+        e.x1   = b->x;
+        e.y    = a->y;
+        e.step = s;
+        e.rem  = dy - (s * dx);
+        e.err  = 0;
+        e.dx   = dx;
+
+        for (j = num_edges; (j > 0) && (edges[j - 1].x0 > e.x0); j--)
+        {
+            edges[j] = edges[j - 1];
+        }
+        edges[j] = e;
+        num_edges++;
+    }
+
+    x_first = (xmin < 0) ? 0 : xmin;
+    x_last  = (xmax > SH1106_DISPLAYABLE_WIDTH_PIXELS) ? (SH1106_DISPLAYABLE_WIDTH_PIXELS - 1) : (xmax - 1);
+
+    for (x = x_first; x <= x_last; x++)
+    {
+        // Retire edges that ended at the last column, then add those starting
+        // here (at the first column, also those that started off the left).
+        for (i = 0, j = 0; i < num_active; i++)
+        {
+            if (edges[active[i]].x1 > x)
+            {
+                active[j++] = active[i];
+            }
+        }
+        num_active = j;
+
+        for (; (next < num_edges) && (edges[next].x0 <= x); next++)
+        {
+            if (edges[next].x1 > x)
+            {
+                SH1106_PolyEdgeStep(&edges[next], x - edges[next].x0);
+                active[num_active++] = next;
+            }
+        }
+
+        // The order only changes where edges cross, so this is usually one pass.
+        for (i = 1; i < num_active; i++)
+        {
+            uint8_t k = active[i];
+
+            for (j = i; (j > 0) && (edges[active[j - 1]].y > edges[k].y); j--)
+            {
+                active[j] = active[j - 1];
+            }
+            active[j] = k;
+        }
+
+        winding = 0;
+        for (i = 0; i < num_active; i++)
+        {
+            SH1106_PolyEdge *e = &edges[active[i]];
+            int8_t was = winding;
+
+            winding = (mode == SH1106_POLY_NONZERO) ? (winding + e->dir) : (winding ^ 1);
+
+            if (was == 0)
+            {
+                top = e->y;
+            }
+            else if (winding == 0)
+            {
+                SH1106_PolySpan(x, top, e->y, color);
+            }
+
+            SH1106_PolyEdgeStep(e, 1);
+        }
+    }
+}
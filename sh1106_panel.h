@@ -5,7 +5,17 @@
 
 #include <xc.h> // include processor files - each processor file is guarded.  
 
+#include <stdbool.h>
+
+// Set to 0 to build without the frame buffer; drawing then reads, modifies and
+// writes the panel's display RAM directly (committed by SH1106_Display()), or goes
+// through SH1106_RenderStrips().
+#ifndef SH1106_USE_FRAMEBUFFER
+#define SH1106_USE_FRAMEBUFFER          1
+#endif
+
 #define I2C_OLED_ADDRESS                0x3C
+#define I2C_OLED_ADDRESS_ALT            0x3D    // SA0 pulled high (second panel).
 
 #define ROUND_UP_TO_BYTE_BOUNDARY(n)    ((n + 8 - 1) & ~(8 - 1))
 #define ROUND_DOWN_TO_BYTE_BOUNDARY(n)  (n & ~(8 - 1))
@@ -19,9 +29,31 @@
 #define SH1106_BUFFER_LINE_WIDTH_BYTES  (ROUND_UP_TO_BYTE_BOUNDARY(SH1106_REAL_OLED_WIDTH_PIXELS) / NUM_BITS_TO_A_BYTE)
 #define SH1106_BUFFER_NUM_LINES         (SH1106_REAL_OLED_HEIGHT_PIXELS)
 
+#define SH1106_BUFFER_SIZE_BYTES        (SH1106_BUFFER_LINE_WIDTH_BYTES * SH1106_BUFFER_NUM_LINES)
+
 #define SH1106_DISPLAYABLE_WIDTH_PIXELS  ROUND_DOWN_TO_BYTE_BOUNDARY(SH1106_REAL_OLED_WIDTH_PIXELS)
 #define SH1106_DISPLAYABLE_HEIGHT_PIXELS ROUND_DOWN_TO_BYTE_BOUNDARY(SH1106_REAL_OLED_HEIGHT_PIXELS)
 
+// Frame buffer is organized as pages of 8 lines, one byte per column.
+#define SH1106_NUM_PAGES                (SH1106_DISPLAYABLE_HEIGHT_PIXELS / NUM_LINES_IN_A_PAGE)
+#define SH1106_PAGE_WIDTH_BYTES         SH1106_DISPLAYABLE_WIDTH_PIXELS
+
+// First displayable column in the controller's 132 column display RAM.
+#define SH1106_COLUMN_OFFSET            2
+
+// Columns the image can be shifted either way (see SH1106_SetPixelShift()).
+#define SH1106_MAX_SHIFT_X              SH1106_COLUMN_OFFSET
+
+// I2C control bytes.  Co (bit 7) set means a single byte follows before the next
+// control byte, D/C (bit 6) selects display data rather than commands.
+#define SH1106_CONTROL_COMMAND_STREAM   0x00
+#define SH1106_CONTROL_COMMAND          0x80
+#define SH1106_CONTROL_DATA_STREAM      0x40
+
+// Status byte returned by reading with the command control byte.
+#define SH1106_STATUS_BUSY              0x80
+#define SH1106_STATUS_DISPLAYOFF        0x40
+
 #define SH1106_SETCONTRAST              0x81
 #define SH1106_DISPLAYALLON_RESUME      0xA4
 #define SH1106_DISPLAYALLON             0xA5
@@ -71,19 +103,152 @@
 
 #define sh1106_swap(a, b) { int16_t t = a; a = b; b = t; }
 
+// Polygon vertex.
+typedef struct {
+  int16_t x, y;
+} SH1106_Point;
+
+// SH1106_DrawPolygon() modes: an outline, or a fill by the even-odd or non-zero
+// winding rule.
+#define SH1106_POLY_OUTLINE     0
+#define SH1106_POLY_EVENODD     1
+#define SH1106_POLY_NONZERO     2
+
+// Most vertices SH1106_DrawPolygon() fills; a fill with more draws nothing.
+#define SH1106_POLY_MAX_POINTS  24
+
+// Panel rotations, numbered as in Adafruit GFX.  The controller can only mirror
+// its rows and columns so quarter turns aren't supported.
+#define SH1106_ROTATE_0         0
+#define SH1106_ROTATE_180       2
+
+// With page checksums on (SH1106_SetPageChecksums()) a page that changed but has
+// the same CRC-16 as when it was last sent is skipped, about 1 in 65536 changed
+// pages.  Pages skipped by CRC are sent anyway every SH1106_PAGE_CRC_REFRESH
+// flips, so such a miss shows for at most that many frames.
+#define SH1106_PAGE_CRC_REFRESH 64
+
+// Number of panel settings mirrored for each panel.
+#define SH1106_CONFIG_COUNT     13
+
 #define BLACK       0
 #define WHITE       1
 #define INVERSE     2
 
+// Bus usage accumulated over one SH1106_Display() frame.
+typedef struct {
+  uint16_t transactions;    ///< I2C START -> STOP cycles issued
+  uint16_t overheadBytes;   ///< Address, control and command bytes sent
+  uint16_t dataBytes;       ///< Display RAM bytes sent
+  uint16_t runs;            ///< Column runs sent (one transaction each)
+  uint16_t skipped;         ///< Dirty pages skipped as unchanged (page checksums)
+  uint16_t errors;          ///< Transfers that failed
+  uint16_t retries;         ///< Runs resent after recovering the bus
+} SH1106_FrameStats;
+
+// Where a flush transfer last failed.  The run stays latched and the flush
+// resumes from it.
+typedef struct {
+  int status;               ///< I2C error (I2C_Err_*)
+  uint8_t address;          ///< Panel's I2C address
+  uint8_t page;             ///< Page of the failed run
+  uint8_t column;           ///< First column of the failed run
+} SH1106_FlushError;
+
+// One panel and the state the driver keeps for it.  Drawing and the calls below
+// act on the selected panel (see SH1106_SelectPanel()); SH1106_DisplayAll() flushes
+// every panel added with SH1106_AddPanel().  Treat the fields as private.  Place
+// it in persistent RAM for SH1106_WarmStart() to skip re-initializing the panel
+// after a reset.
+typedef struct SH1106_Panel {
+  uint8_t address;                      ///< 7-bit I2C address
+  uint8_t rotation;                     ///< SH1106_ROTATE_0 or SH1106_ROTATE_180
+  uint8_t column_offset;                ///< Display RAM column of frame buffer column 0
+  int8_t shift_y;                       ///< Lines the image is shifted down
+  uint8_t orbit_step;                   ///< Position along the pixel orbit
+  uint8_t edge_clear;                   ///< Pages whose RAM either side of the image still needs clearing
+  uint8_t *frame_buffer;                ///< Frame buffer given to SH1106_AddPanel()
+  uint8_t *back_buffer;                 ///< Buffer drawn into
+  uint8_t *front_buffer;                ///< Buffer flushes read from
+  uint8_t *shadow_buffer;               ///< Copy of the panel's display RAM, if enabled
+  uint8_t shadow_stale;                 ///< Pages the shadow copy can't be trusted for
+  uint8_t dirty_lo[SH1106_NUM_PAGES];   ///< Columns drawn since the last flip (lo > hi: clean)
+  uint8_t dirty_hi[SH1106_NUM_PAGES];
+  uint8_t flush_lo[SH1106_NUM_PAGES];   ///< Columns latched for the flush
+  uint8_t flush_hi[SH1106_NUM_PAGES];
+  uint8_t flush_page;                   ///< Next page the flush looks at
+  bool flushing;                        ///< Taking part in the flush in progress
+  uint8_t start_line;                   ///< Display RAM line shown at the top
+  bool page_crc_enabled;                ///< Skip pages by CRC (SH1106_SetPageChecksums())
+  uint8_t page_crc_valid;               ///< Pages the panel holds exactly as page_crc says
+  uint8_t page_crc_skipped;             ///< Pages skipped by CRC since the last refresh
+  uint8_t page_crc_flips;               ///< Flips since the last refresh
+  uint16_t page_crc[SH1106_NUM_PAGES];
+  uint8_t config[SH1106_CONFIG_COUNT];  ///< Mirror of the panel's settings
+  uint16_t config_check;                ///< Check word over config (survives resets)
+  bool config_known;                    ///< config can be trusted to skip settings
+  uint8_t pending[SH1106_CONFIG_COUNT]; ///< Settings to send with the next flush
+  uint16_t pending_mask;                ///< Which of pending are set (bit per setting)
+  SH1106_FrameStats frame_stats;        ///< Bus usage of the frame in progress
+  SH1106_FrameStats last_frame_stats;   ///< Bus usage of the last flushed frame
+  struct SH1106_Panel *next;
+} SH1106_Panel;
+
+// Called from interrupt context when SH1106_DisplayAsync() finishes.
+typedef void (*SH1106_FlushCallback)(bool success);
+
+// Draws the scene for SH1106_RenderStrips(); called once per page.
+typedef void (*SH1106_DrawCallback)(uint8_t page);
+
 #define PI          3.1415926
 #define TWO_PI      (2.0 * PI)
 #define ONE_RADIAN  (PI / 180.0)
 
+void SH1106_AddPanel(SH1106_Panel *p, uint8_t address, uint8_t *frame_buffer, uint8_t rotation);
+SH1106_Panel *SH1106_SelectPanel(SH1106_Panel *p);
+void SH1106_SetRotation(uint8_t rotation);
+void SH1106_SetPixelShift(int8_t dx, int8_t dy);
+void SH1106_OrbitStep(void);
 void SH1106_InitDisplay(void);
+bool SH1106_WarmStart(void);
+int  SH1106_DrawSplash(const uint8_t *image);
 void SH1106_DrawPixel(uint16_t x, uint16_t y, uint16_t color);
+void SH1106_DrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+void SH1106_DrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 void SH1106_InvertDisplay(bool invert);
+void SH1106_SetContrast(uint8_t contrast);
+void SH1106_SetDisplayOn(bool on);
+int  SH1106_ApplySettings(void);
+int16_t SH1106_Scroll(int8_t lines);
+uint8_t SH1106_GetStartLine(void);
+void SH1106_BeginCommands(void);
+void SH1106_QueueCommand(uint8_t c);
+void SH1106_QueueCommandArg(uint8_t c, uint8_t arg);
+int  SH1106_SendCommands(void);
 void SH1106_ClearDisplay(void);
+void SH1106_InvalidateDisplay(void);
 void SH1106_Display(void);
+bool SH1106_DisplayAsync(void);
+void SH1106_DisplayAll(void);
+bool SH1106_DisplayAllAsync(void);
+int  SH1106_DisplayRegion(int16_t x, int16_t y, int16_t w, int16_t h);
+int  SH1106_DisplayImage(const uint8_t *image, int16_t x, int16_t y, int16_t w, int16_t h);
+void SH1106_SetDrawTarget(uint8_t *target);
+int  SH1106_RenderStrips(uint8_t *strip, SH1106_DrawCallback draw);
+int  SH1106_RenderPages(uint8_t *strip, SH1106_DrawCallback draw, uint8_t pages);
+void SH1106_Flip(void);
+void SH1106_SetBackBuffer(uint8_t *back);
+void SH1106_SetShadowBuffer(uint8_t *shadow);
+void SH1106_SetPageChecksums(bool enable);
+bool SH1106_IsFlushBusy(void);
+void SH1106_SetFlushCallback(SH1106_FlushCallback callback);
+void SH1106_GetFrameStats(SH1106_FrameStats *stats);
+void SH1106_GetPanelStats(const SH1106_Panel *p, SH1106_FrameStats *stats);
+bool SH1106_GetFlushError(SH1106_FlushError *error);
+const uint8_t *SH1106_GetFrontBuffer(void);
+uint16_t SH1106_PageCrc(const uint8_t *data);
 void SH1106_DrawCircle (uint8_t x, uint8_t y, uint8_t r, uint16_t color, bool fill);
 void SH1106_DrawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t color, bool fill);
-void SH1106_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
\ No newline at end of file
+void SH1106_DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+void SH1106_DrawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool fill);
+void SH1106_DrawPolygon(const SH1106_Point *points, uint8_t count, uint16_t color, uint8_t mode);
\ No newline at end of file
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#
+# Rebuilds the SH1106 panel image from the stream sent by sh1106_mirror.c and
+# writes each frame as a PBM image (lit pixels white).
+#
+#   sh1106_mirror.py /dev/ttyUSB0 --baud 19200 --out frames
+#   sh1106_mirror.py capture.bin --latest screen.pbm
+#
+# Reading a serial port needs pyserial and runs until interrupted (Ctrl-C);
+# anything else is read as a file ('-' for stdin) to its end.  The image starts
+# out black until the device's first full pass arrives.
+
+import argparse
+import os
+import sys
+
+SYNC0 = 0xA5
+SYNC1 = 0x5A
+PAGE = ord('P')
+FRAME = ord('F')
+
+WIDTH = 128
+PAGES = 8
+HEIGHT = PAGES * 8
+
+
+def unpack(payload):
+    """Decode a page payload (see sh1106_mirror.h); None if it's malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(payload):
+        control = payload[i]
+        i += 1
+        if control < 0x80:
+            count = control + 1
+            if i + count > len(payload):
+                return None
+            out += payload[i:i + count]
+            i += count
+        else:
+            if i >= len(payload):
+                return None
+            out += bytes([payload[i]]) * (control - 125)
+            i += 1
+    return out if len(out) == WIDTH else None
+
+
+def packets(stream, live):
+    """Yield (type, page, payload) for each packet with a good check byte,
+    resynchronizing on the sync bytes after noise or a dropped byte.  A live
+    stream (serial port) is read until interrupted; an empty read there is just
+    a read timeout on a screen that isn't changing."""
+    buf = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            if live:
+                continue
+            return
+        buf += chunk
+        while True:
+            start = buf.find(bytes([SYNC0, SYNC1]))
+            if start < 0:
+                del buf[:-1]
+                break
+            del buf[:start]
+            if len(buf) < 5 or len(buf) < 6 + buf[4]:
+                break
+            length = buf[4]
+            body = buf[2:6 + length]
+            if sum(body) & 0xFF:
+                del buf[:1]
+                continue
+            yield body[0], body[1], bytes(body[3:3 + length])
+            del buf[:6 + length]
+
+
+def to_pbm(image):
+    """Convert the page layout (one byte per column, LSB at the top) to P4."""
+    rows = bytearray()
+    for y in range(HEIGHT):
+        page = image[(y // 8) * WIDTH:(y // 8 + 1) * WIDTH]
+        bit = 1 << (y % 8)
+        for x0 in range(0, WIDTH, 8):
+            byte = 0
+            for x in range(x0, x0 + 8):
+                # PBM 1 is black; show lit pixels white.
+                byte = (byte << 1) | (0 if page[x] & bit else 1)
+            rows.append(byte)
+    return b'P4\n%d %d\n' % (WIDTH, HEIGHT) + bytes(rows)
+
+
+def write_file(path, data):
+    tmp = path + '.tmp'
+    with open(tmp, 'wb') as f:
+        f.write(data)
+    os.replace(tmp, path)
+
+
+def open_input(args):
+    """Return (stream, live); live streams don't end at an empty read."""
+    if args.input == '-':
+        return sys.stdin.buffer, False
+    if os.path.exists(args.input) and not args.input.startswith('/dev/'):
+        return open(args.input, 'rb'), False
+    import serial
+    return serial.Serial(args.input, args.baud, timeout=1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Rebuild SH1106 mirror frames as PBM images.')
+    parser.add_argument('input', help="serial port, capture file or '-'")
+    parser.add_argument('--baud', type=int, default=19200)
+    parser.add_argument('--out', help='directory to write numbered frames to')
+    parser.add_argument('--latest', help='file to overwrite with each frame')
+    args = parser.parse_args()
+
+    if not args.out and not args.latest:
+        args.latest = 'sh1106.pbm'
+    if args.out:
+        os.makedirs(args.out, exist_ok=True)
+
+    image = bytearray(WIDTH * PAGES)
+    frames = 0
+    try:
+        for kind, page, payload in packets(*open_input(args)):
+            if kind == PAGE and page < PAGES:
+                data = unpack(payload)
+                if data is not None:
+                    image[page * WIDTH:(page + 1) * WIDTH] = data
+            elif kind == FRAME:
+                pbm = to_pbm(image)
+                if args.out:
+                    write_file(os.path.join(args.out, 'frame%05d.pbm' % frames), pbm)
+                if args.latest:
+                    write_file(args.latest, pbm)
+                frames += 1
+    except KeyboardInterrupt:
+        pass
+
+    print('%d frames' % frames, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
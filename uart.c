@@ -0,0 +1,128 @@
+#include <xc.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "system.h"
+#include "uart.h"
+
+
+//-------------------Variables-------------------
+// Interrupt-driven transmit queue.  Head is only moved by the writer and tail by
+// the interrupt handler, so neither needs to mask the other.
+static uint8_t TxQueue[UART_TX_QUEUE_SIZE];
+static volatile uint16_t TxHead = 0;
+static volatile uint16_t TxTail = 0;
+
+#define UART_TX_QUEUE_MASK	(UART_TX_QUEUE_SIZE - 1)
+
+
+//-------------------Functions-------------------
+
+// Sets up UART1 for 8N1 at the given baud rate with interrupt-driven transmit.
+// The U1TX pin must already be mapped (see InitApp()).
+//*******************************************************************************
+void UART1_Initialize(uint32_t baud)
+{
+	U1MODE = 0;						// 8N1, BRGH = 0 (16x clock).
+	U1STA  = 0;						// TX interrupt when a byte moves to the shift register.
+	U1BRG  = (uint16_t)((((uint32_t)(FCY)) / (16UL * baud)) - 1);
+
+	TxHead = TxTail = 0;
+
+	IEC0bits.U1TXIE = 0;
+	IFS0bits.U1TXIF = 0;
+
+	U1MODEbits.UARTEN = 1;
+	U1STAbits.UTXEN   = 1;
+}
+
+
+// Queues up to count bytes for transmission without waiting.  Returns the number
+// queued, which is less than count when the queue fills.
+//*******************************************************************************
+uint16_t UART1_Write(const uint8_t *data, uint16_t count)
+{
+	uint16_t free = UART1_TxFree();
+	uint16_t i;
+
+	if (count > free)
+	{
+		count = free;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		TxQueue[TxHead] = data[i];
+		TxHead = (TxHead + 1) & UART_TX_QUEUE_MASK;
+	}
+
+	// The interrupt flag is left set once the hardware buffer has room, so this
+	// starts sending straight away if the transmitter was idle.
+	if (count > 0)
+	{
+		IEC0bits.U1TXIE = 1;
+	}
+
+	return count;
+}
+
+
+// Returns the number of bytes UART1_Write() can currently queue.
+//*******************************************************************************
+uint16_t UART1_TxFree(void)
+{
+	return (TxTail - TxHead - 1) & UART_TX_QUEUE_MASK;
+}
+
+
+// Returns true once everything queued has left the shift register.
+//*******************************************************************************
+bool UART1_IsTxIdle(void)
+{
+	return ((TxHead == TxTail) && (U1STAbits.TRMT == 1));
+}
+
+
+// Formatted debug output.  Text that doesn't fit in the queue is dropped rather
+// than waited for.
+//*******************************************************************************
+void UART1_printf(const char *format, ...)
+{
+	char text[96];
+	va_list args;
+	int len;
+
+	va_start(args, format);
+	len = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	if (len <= 0)
+	{
+		return;
+	}
+	if (len >= (int)sizeof(text))
+	{
+		len = sizeof(text) - 1;
+	}
+
+	UART1_Write((const uint8_t *)text, (uint16_t)len);
+}
+
+
+// Moves queued bytes into the transmit buffer.  Must be called from the U1TX
+// interrupt handler after clearing the interrupt flag.
+//*******************************************************************************
+void UART1_TxInterrupt(void)
+{
+	while ((TxTail != TxHead) && (U1STAbits.UTXBF == 0))
+	{
+		U1TXREG = TxQueue[TxTail];
+		TxTail = (TxTail + 1) & UART_TX_QUEUE_MASK;
+	}
+
+	if (TxTail == TxHead)
+	{
+		IEC0bits.U1TXIE = 0;
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//--------------------Constants--------------------
+// Transmit queue size (holds one byte less).  Must be a power of two no larger
+// than 256.
+#define UART_TX_QUEUE_SIZE	256
+
+
+//--------------------Functions--------------------
+void     UART1_Initialize(uint32_t);
+uint16_t UART1_Write(const uint8_t *, uint16_t);
+uint16_t UART1_TxFree(void);
+bool     UART1_IsTxIdle(void);
+void     UART1_printf(const char *, ...);
+void     UART1_TxInterrupt(void);
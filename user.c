@@ -33,5 +33,8 @@ void InitApp(void)
     /* Setup analog functionality and port direction */
 
     /* Initialize peripherals */
+
+    /* Map U1TX to RP17 (RF5) for the display mirror. */
+    _RP17R = 3;
 }
 